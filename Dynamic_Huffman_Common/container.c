@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include "container.h"
+
+
+// one chunk, the input and the output of a thread
+struct _Chunk{
+    unsigned char* input;
+    long input_len;
+    long input_size;            // size of the input buffer
+    unsigned char* output;      // malloc by the thread
+    long output_len;
+    ChunkCoder coder;
+};
+typedef struct _Chunk* Chunk;
+
+
+// thread functions, code one chunk in memory
+void* compress_chunk(void* arg);
+void* decompress_chunk(void* arg);
+
+// 4 bytes numbers, msb first
+void put_uint32(FILE* fp, uint32_t x);
+// return -1 at the end of file
+long get_uint32(FILE* fp);
+
+
+/*************************************************************/
+// the chunk is a memory file for the coder, and the output goes to a
+// temporary file, since the coder re-writes the first byte at the end
+void* compress_chunk(void* arg){
+    Chunk ck = (Chunk) arg;
+
+    FILE* in = fmemopen(ck->input, ck->input_len, "rb");
+    FILE* out = tmpfile();
+    assert(in != NULL && out != NULL);
+
+    ck->coder->compress(in, out, ck->coder->param);
+
+    // read back the whole output
+    fseek(out, 0, SEEK_END);
+    ck->output_len = ftell(out);
+    rewind(out);
+
+    ck->output = (unsigned char*) malloc(ck->output_len);
+    assert(ck->output != NULL);
+    long n = fread(ck->output, 1, ck->output_len, out);
+    assert(n == ck->output_len);
+
+    fclose(in);
+    fclose(out);
+    return NULL;
+}
+
+
+/*************************************************************/
+void* decompress_chunk(void* arg){
+    Chunk ck = (Chunk) arg;
+
+    char* buffer = NULL;
+    size_t size = 0;
+    FILE* in = fmemopen(ck->input, ck->input_len, "rb");
+    FILE* out = open_memstream(&buffer, &size);
+    assert(in != NULL && out != NULL);
+
+    ck->coder->decompress(in, out);
+
+    fclose(in);
+    fclose(out);
+
+    ck->output = (unsigned char*) buffer;
+    ck->output_len = size;
+    return NULL;
+}
+
+
+/*************************************************************/
+// read "threads" chunks, compress them at the same time, print them in order,
+// and repeat until the end of the file
+void container_compress(FILE* fp, FILE* fp_out, long chunk_size, int threads, ChunkCoder coder){
+    assert(fp != NULL && fp_out != NULL && coder != NULL);
+    assert(chunk_size > 0 && chunk_size <= (long) CHUNK_MAX_KB * 1024);
+    assert(threads >= 1);
+
+    putc(CHUNK_MARK, fp_out);
+    put_uint32(fp_out, chunk_size);
+
+    struct _Chunk* chunks = (struct _Chunk*) malloc(threads * sizeof(struct _Chunk));
+    pthread_t* tids = (pthread_t*) malloc(threads * sizeof(pthread_t));
+    assert(chunks != NULL && tids != NULL);
+
+    for (int i = 0; i < threads; i++){
+        chunks[i].input = (unsigned char*) malloc(chunk_size);
+        assert(chunks[i].input != NULL);
+        chunks[i].coder = coder;
+    }
+
+    bool finish = false;
+    int running;
+
+    while (! finish){
+        // read and start
+        running = 0;
+        while (running < threads && ! finish){
+            Chunk ck = &chunks[running];
+            ck->input_len = fread(ck->input, 1, chunk_size, fp);
+
+            if (ck->input_len < chunk_size){
+                finish = true;
+            }
+
+            if (ck->input_len > 0){
+                pthread_create(&tids[running], NULL, compress_chunk, ck);
+                running += 1;
+            }
+        }
+
+        // wait and print in order
+        for (int i = 0; i < running; i++){
+            Chunk ck = &chunks[i];
+            pthread_join(tids[i], NULL);
+
+            put_uint32(fp_out, ck->output_len);
+            fwrite(ck->output, 1, ck->output_len, fp_out);
+
+            free(ck->output);
+            ck->output = NULL;
+        }
+    }
+
+    for (int i = 0; i < threads; i++){
+        free(chunks[i].input);
+    }
+    free(chunks);
+    free(tids);
+
+    return;
+}
+
+
+/*************************************************************/
+// the same for decompression: read "threads" chunks, decompress them
+// at the same time, and print them in order
+void container_decompress(FILE* fp, FILE* fp_out, int threads, ChunkCoder coder){
+    assert(fp != NULL && fp_out != NULL && coder != NULL);
+    assert(threads >= 1);
+
+    // the chunk size is not needed, each chunk has its own end
+    if (get_uint32(fp) < 0){
+        fprintf(stderr, "Decompress Error: not a valid %s file\n", coder->suffix);
+        exit(EXIT_FAILURE);
+    }
+
+    struct _Chunk* chunks = (struct _Chunk*) malloc(threads * sizeof(struct _Chunk));
+    pthread_t* tids = (pthread_t*) malloc(threads * sizeof(pthread_t));
+    assert(chunks != NULL && tids != NULL);
+
+    for (int i = 0; i < threads; i++){
+        chunks[i].input = NULL;
+        chunks[i].input_size = 0;
+        chunks[i].coder = coder;
+    }
+
+    bool finish = false;
+    int running;
+
+    while (! finish){
+        // read and start
+        running = 0;
+        while (running < threads && ! finish){
+            Chunk ck = &chunks[running];
+            long len = get_uint32(fp);
+
+            if (len < 0){
+                finish = true;
+                break;
+            }
+
+            // the input buffer only grows
+            if (len > ck->input_size){
+                ck->input = (unsigned char*) realloc(ck->input, len);
+                assert(ck->input != NULL);
+                ck->input_size = len;
+            }
+
+            ck->input_len = fread(ck->input, 1, len, fp);
+            if (ck->input_len != len || len == 0){
+                fprintf(stderr, "Decompress Error: the chunk is cut\n");
+                exit(EXIT_FAILURE);
+            }
+
+            pthread_create(&tids[running], NULL, decompress_chunk, ck);
+            running += 1;
+        }
+
+        // wait and print in order
+        for (int i = 0; i < running; i++){
+            Chunk ck = &chunks[i];
+            pthread_join(tids[i], NULL);
+
+            fwrite(ck->output, 1, ck->output_len, fp_out);
+
+            free(ck->output);
+            ck->output = NULL;
+        }
+    }
+
+    for (int i = 0; i < threads; i++){
+        free(chunks[i].input);
+    }
+    free(chunks);
+    free(tids);
+
+    return;
+}
+
+
+/*************************************************************/
+void put_uint32(FILE* fp, uint32_t x){
+    putc((x >> 24) & 0xFF, fp);
+    putc((x >> 16) & 0xFF, fp);
+    putc((x >> 8) & 0xFF, fp);
+    putc(x & 0xFF, fp);
+    return;
+}
+
+
+/*************************************************************/
+long get_uint32(FILE* fp){
+    long x = 0;
+    int c;
+
+    for (int i = 0; i < 4; i++){
+        c = getc(fp);
+        if (c == EOF){
+            return -1;
+        }
+        x = (x << 8) | c;
+    }
+
+    return x;
+}
@@ -0,0 +1,57 @@
+/*
+* Container of chunks, for both dynamic huffman coders (FGK and Vitter):
+* the input is cut into chunks of chunk_size bytes, and each chunk is coded
+* with a new tree, as a whole file of its own. The chunks do not depend on
+* each other, so several threads can code them at the same time, the price
+* is that each tree starts empty again.
+* The coder is called back for each chunk, in memory, from a thread.
+*/
+
+
+#ifndef _CONTAINER_H_
+#define _CONTAINER_H_
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+
+// the marks: a plain .FGK or .v file starts with the byte of the padded
+// bits and the rescale bits (PAD_BITS), and the rescale bits are at most
+// RESCALE_MAX_BITS (30). so a first byte of 31 rescale bits, 0xF8 and up,
+// never starts a plain file, and the headers take their marks from there:
+//      0xFF    CHUNK_MARK, both coders
+//      0xFE    STREAM_MARK of FGK, WIDE_MARK of Vitter
+//      0xFD    DEFERRED_MARK of Vitter
+//
+// file structure:
+//      CHUNK_MARK (1 byte), chunk size (4 bytes)
+//      for each chunk: the compressed size (4 bytes), then the chunk
+// numbers are msb first
+#define CHUNK_MARK 0xFF
+
+// chunk size in KB, from 1 KB to 1 GB
+#define CHUNK_MAX_KB (1 << 20)
+
+
+// the coder of one chunk: compress writes a whole file from "in" to "out",
+// and may seek back in "out" to re-write its first byte. decompress reads
+// it back. both are called from several threads at the same time
+struct _ChunkCoder{
+    void (*compress)(FILE* in, FILE* out, const void* param);
+    void (*decompress)(FILE* in, FILE* out);
+    const void* param;          // the options of compress, as they are
+    const char* suffix;         // ".FGK" or ".v", for the error messages
+};
+typedef struct _ChunkCoder* ChunkCoder;
+
+
+// compress fp into chunks, "threads" chunks are coded at the same time
+void container_compress(FILE* fp, FILE* fp_out, long chunk_size, int threads, ChunkCoder coder);
+
+// decompress the chunks, CHUNK_MARK is already read
+void container_decompress(FILE* fp, FILE* fp_out, int threads, ChunkCoder coder);
+
+
+#endif
@@ -3,26 +3,92 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
+#include <unistd.h>
 #include "FGK_functions.h"
+#include "tree.h"
+#include "chunk.h"
+
+
+// print the usage and exit
+void usage(const char* name);
 
 
 int main(int argc, const char** argv){
-    // Usage: ./FGK -compress/-decompress file
-    if (argc != 3){
-        fprintf(stderr, "Usage: %s <-compress|-decompress> <file>\n", argv[0]);
-        exit(EXIT_FAILURE);
+    // Usage: ./FGK -compress/-decompress file [options]
+    if (argc < 3 || argc % 2 == 0){
+        usage(argv[0]);
     }
 
+    bool compress = false;
     if (strcmp(argv[1], "-compress") == 0){
-        FGK_compress(argv[2]);
+        compress = true;
+    }
+    else if (strcmp(argv[1], "-decompress") != 0){
+        usage(argv[0]);
     }
-    else if(strcmp(argv[1], "-decompress") == 0){
-        FGK_decompress(argv[2]);
+
+    // rescale the tree when the total count reaches 2^bits, 0 = default
+    int rescale_bits = 0;
+    // chunk size in KB, 0 = one tree for the whole file
+    long chunk_kb = 0;
+    int threads = 1;
+
+    // options come in pairs after the file name
+    for (int i = 3; i < argc; i += 2){
+        if (strcmp(argv[i], "-r") == 0 && compress){
+            rescale_bits = atoi(argv[i+1]);
+            if (rescale_bits < RESCALE_MIN_BITS || rescale_bits > RESCALE_MAX_BITS){
+                fprintf(stderr, "rescale bits must be %d to %d\n", RESCALE_MIN_BITS, RESCALE_MAX_BITS);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-s") == 0 && compress){
+            chunk_kb = atol(argv[i+1]);
+            if (chunk_kb < 1 || chunk_kb > CHUNK_MAX_KB){
+                fprintf(stderr, "chunk size must be 1 to %d KB\n", CHUNK_MAX_KB);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-j") == 0){
+            threads = atoi(argv[i+1]);
+            if (threads < 1){
+                usage(argv[0]);
+            }
+        }
+        else{
+            usage(argv[0]);
+        }
+    }
+
+    // "-" is a stream from stdin to stdout, a pipe can not go back to
+    // the first byte, so it has its own format, and no chunks
+    if (strcmp(argv[2], "-") == 0){
+        if (chunk_kb != 0){
+            usage(argv[0]);
+        }
+
+        if (compress){
+            FGK_stream_compress(STDIN_FILENO, stdout, rescale_bits);
+        }
+        else{
+            FGK_stream_decompress(STDIN_FILENO, stdout);
+        }
+    }
+    else if (compress){
+        FGK_compress(argv[2], rescale_bits, chunk_kb * 1024, threads);
     }
     else{
-        fprintf(stderr, "Usage: %s <-compress|-decompress> <file>\n", argv[0]);
-        exit(EXIT_FAILURE);
+        FGK_decompress(argv[2], threads);
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+
+void usage(const char* name){
+    fprintf(stderr, "Usage: %s -compress <file> [-r rescale bits, %d-%d] [-s chunk KB] [-j threads]\n", 
+            name, RESCALE_MIN_BITS, RESCALE_MAX_BITS);
+    fprintf(stderr, "       %s -decompress <file.FGK> [-j threads]\n", name);
+    fprintf(stderr, "       file \"-\": stream from stdin to stdout\n");
+    exit(EXIT_FAILURE);
+}
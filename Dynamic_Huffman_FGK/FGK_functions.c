@@ -3,30 +3,22 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
-#include <math.h>
+#include <errno.h>
+#include <unistd.h>
 #include "tree.h"
 #include "FGK_functions.h"
-
-
-// a constant array, replace pow(2, xx) function 
-// so, power_of_two[2] = 2^2 = 4
-const int power_of_two[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
-
-
-// decompress file main function
-// read a char, update the tree and then output related chars. 
-void decompress_file(FILE* fp, FILE* fp_out, Tree tr);
+#include "chunk.h"
 
 
 /*************************************************************/
-void FGK_compress(const char* filename){
+void FGK_compress(const char* filename, int rescale_bits, long chunk_size, int threads){
     // first open the input file
     FILE* fp = fopen(filename, "rb");
     assert(fp != NULL);
 
     // create filename for output
     // original name + .FGK, also +1 for \0
-    char* filename_out = (char*) malloc(strlen(filename+4+1) * sizeof(char));
+    char* filename_out = (char*) malloc((strlen(filename)+4+1) * sizeof(char));
     assert(filename_out != NULL);
 
     strcpy(filename_out, filename);
@@ -35,6 +27,48 @@ void FGK_compress(const char* filename){
     // create the file fp for output
     FILE* fp_out = fopen(filename_out, "wb");
     assert(fp_out != NULL);
+
+    if (chunk_size > 0){
+        // container of chunks, each with its own tree
+        chunk_compress(fp, fp_out, chunk_size, threads, rescale_bits);
+    }
+    else{
+        compress_file(fp, fp_out, rescale_bits);
+    }
+
+    // print some compression status
+    fseek(fp, 0, SEEK_END);
+    long original_size = ftell(fp);
+
+    fseek(fp_out, 0, SEEK_END);
+    long new_size = ftell(fp_out);
+
+    fprintf(stdout, "Input file: %s\n", filename);
+    fprintf(stdout, "Size %.2f KB\n", (float) original_size / 1024);
+
+    fprintf(stdout, "Output compressed file: %s\n", filename_out);
+    fprintf(stdout, "Size %.2f KB\n", (float) new_size / 1024);
+
+    fprintf(stdout, "Space saving %.2f%%\n", (1 - ((float) new_size / original_size)) * 100);
+
+    // close files
+    fclose(fp);
+    fclose(fp_out);
+    fp = NULL;
+    fp_out = NULL;
+
+    // free the char*
+    free(filename_out);
+    filename_out = NULL;
+
+    return;
+}
+
+
+/*************************************************************/
+void compress_file(FILE* fp, FILE* fp_out, int rescale_bits){
+    assert(fp != NULL && fp_out != NULL);
+
     // output a char first
     // this char represent the number of digits padded
     // so initialize to zero.
@@ -43,60 +77,104 @@ void FGK_compress(const char* filename){
 
     // prepare the tree
     Tree tr = TreeCreate();
-    NodeList ndlist = NodeListCreate();
+    if (rescale_bits != 0){
+        TreeSetRescale(tr, rescale_bits);
+    }
 
     // initialize output buffer
-    char out_c = 0;
-    // number of digits in the output buffer, range 0 - 8
-    // when equal to 8, call putc
-    int out_c_num = 0;
+    BitWriter bw = bit_writer_create(fp_out);
 
     // input buffer
     int c;
 
     // read file and update the tree
     while ((c = getc(fp)) != EOF){
-        TreeUpdate(tr, ndlist, c, fp_out, &out_c, &out_c_num);
+        TreeUpdate(tr, c, bw);
     }
 
     // finish encoding, pad the last char and re-write the first char if necessary
-    pad_last_bit(fp_out, &out_c, &out_c_num);
+    pad_last_bit(bw, rescale_bits);
+    bit_writer_destroy(bw);
 
-    // print some compression status
-    fseek(fp, 0, SEEK_END);
-    long original_size = ftell(fp);
+    // finish, destroy everything
+    TreeDestroy(tr);
+    return;
+}
 
-    fseek(fp_out, 0, SEEK_END);
-    long new_size = ftell(fp_out);
 
-    fprintf(stdout, "Input file: %s\n", filename);
-    fprintf(stdout, "Size %.2f KB\n", (float) original_size / 1024);
+/*************************************************************/
+void FGK_stream_compress(int fd, FILE* fp_out, int rescale_bits){
+    assert(fd >= 0 && fp_out != NULL);
 
-    fprintf(stdout, "Output compressed file: %s\n", filename_out);
-    fprintf(stdout, "Size %.2f KB\n", (float) new_size / 1024);
+    // the first byte can not be re-written later, so it only marks the stream
+    putc(STREAM_MARK, fp_out);
+    putc(rescale_bits, fp_out);
+    fflush(fp_out);
 
-    fprintf(stdout, "Space saving %.2f%%\n", (1 - ((float) new_size / original_size)) * 100);
+    Tree tr = TreeCreate();
+    if (rescale_bits != 0){
+        TreeSetRescale(tr, rescale_bits);
+    }
 
-    // finish, destroy everything
+    BitWriter bw = bit_writer_create(fp_out);
+    unsigned char* buffer = (unsigned char*) malloc(IO_BUFFER_SIZE);
+    assert(buffer != NULL);
+
+    // code whatever each read gives, and write out the whole bytes at once,
+    // at most 7 bits wait in the bit writer for the next read
+    int len;
+    while ((len = read(fd, buffer, IO_BUFFER_SIZE)) != 0){
+        if (len < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            perror("read");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int i = 0; i < len; i++){
+            TreeUpdate(tr, buffer[i], bw);
+        }
+
+        bit_writer_flush(bw);
+        fflush(fp_out);
+    }
+
+    // the end mark, and pad the last byte with 0
+    TreePrintEnd(tr, bw);
+    if (bw->acc_bits != 0){
+        print_to_file(bw, 0, 8 - bw->acc_bits);
+    }
+    bit_writer_flush(bw);
+    fflush(fp_out);
+
+    free(buffer);
+    bit_writer_destroy(bw);
     TreeDestroy(tr);
-    NodeListDestroy(ndlist);
+    return;
+}
 
-    // close files
-    fclose(fp);
-    fclose(fp_out);
-    fp = NULL;
-    fp_out = NULL;
 
-    // free the char*
-    free(filename_out);
-    filename_out = NULL;
+/*************************************************************/
+void FGK_stream_decompress(int fd, FILE* fp_out){
+    assert(fd >= 0 && fp_out != NULL);
 
+    BitReader br = bit_reader_create_fd(fd);
+
+    // only the streaming format comes from a stream
+    if (bit_reader_fill(br, 8) < 8 || bit_reader_get(br, 8) != STREAM_MARK){
+        fprintf(stderr, "Decompress Error: not a FGK stream\n");
+        exit(EXIT_FAILURE);
+    }
+
+    decompress_stream(br, fp_out);
+    bit_reader_destroy(br);
     return;
 }
 
 
 /*************************************************************/
-void FGK_decompress(const char* filename){
+void FGK_decompress(const char* filename, int threads){
     // first check if the filename is valid
     // valid name has .FGK at the end
     int len = strlen(filename);
@@ -121,12 +199,31 @@ void FGK_decompress(const char* filename){
     FILE* fp_out = fopen(filename_out, "wb");
     assert(fp_out != NULL);
 
-    // create the tree
-    // for decompression, no need to use nodelist
-    Tree tr = TreeCreate();
+    // a container of chunks starts with CHUNK_MARK,
+    // and a saved stream with STREAM_MARK
+    int first = getc(fp);
+    if (first == CHUNK_MARK){
+        chunk_decompress(fp, fp_out, threads);
+    }
+    else if (first == STREAM_MARK){
+        BitReader br = bit_reader_create(fp, 0);
+        decompress_stream(br, fp_out);
+        bit_reader_destroy(br);
+    }
+    else{
+        if (first != EOF){
+            ungetc(first, fp);
+        }
+
+        // create the tree
+        Tree tr = TreeCreate();
+
+        // main function to decompress the file
+        decompress_file(fp, fp_out, tr);
 
-    // main function to decompress the file
-    decompress_file(fp, fp_out, tr);
+        // destroy the tree
+        TreeDestroy(tr);
+    }
 
 
     // finish decompression, print out some statistics
@@ -139,9 +236,6 @@ void FGK_decompress(const char* filename){
     fprintf(stdout, "Size: %.2f KB\n", (float) ftell(fp_out) / 1024);
 
 
-    // destroy the tree
-    TreeDestroy(tr);
-
     // close the file
     fclose(fp);
     fclose(fp_out);
@@ -158,50 +252,56 @@ void FGK_decompress(const char* filename){
 
 
 /*************************************************************/
-void print_to_file(FILE* fp_out, char* out_c, int* out_c_num, int new_c, int new_c_num){
+BitWriter bit_writer_create(FILE* fp_out){
+    assert(fp_out != NULL);
+    BitWriter bw = (BitWriter) malloc(sizeof(struct _BitWriter));
+    assert(bw != NULL);
 
-    int transfer_bit_num = 0; 
-    int transfer_bit_buffer = 0;
-    int trasnfer_bit = 0;
-    int shift_num = 0;
+    bw->fp = fp_out;
+    bw->acc = 0;
+    bw->acc_bits = 0;
+    bw->buffer_len = 0;
 
+    return bw;
+}
 
-    while ((*out_c_num) + new_c_num >= 8){
 
-        transfer_bit_num = 8 - *out_c_num;
-        transfer_bit_buffer = power_of_two[transfer_bit_num] - 1;
-        shift_num = new_c_num - transfer_bit_num;
-        trasnfer_bit = (((transfer_bit_buffer << shift_num) & new_c) >> shift_num) & transfer_bit_buffer; 
+/*************************************************************/
+BitWriter bit_writer_destroy(BitWriter bw){
+    assert(bw != NULL);
 
+    free(bw);
+    bw = NULL;
+    return bw;
+}
 
-        // put these onto out_c
-        *out_c <<= transfer_bit_num;
-        *out_c |= trasnfer_bit;
-        putc(*out_c, fp_out);
-        
-        // reset
-        new_c_num -= transfer_bit_num;
 
-        trasnfer_bit = 0;
-        transfer_bit_buffer = 0;
-        transfer_bit_num = 0;
-        shift_num = 0;
+/*************************************************************/
+void print_to_file(BitWriter bw, uint64_t bits, int num){
+    assert(num >= 0 && num <= 64);
+
+    // at most 7 bits are pending, so 57 new bits fit in the accumulator
+    // a longer code is split in two
+    if (num > 56){
+        print_to_file(bw, bits >> 32, num - 32);
+        num = 32;
+    }
 
-        *out_c = 0;
-        *out_c_num = 0;
+    if (num < 64){
+        bits &= ((uint64_t) 1 << num) - 1;
     }
+    bw->acc = (bw->acc << num) | bits;
+    bw->acc_bits += num;
 
-    // now append the rest
-    if (new_c_num > 0){
-        transfer_bit_num = new_c_num;
-        // no need to shift the transfer_bit
-        // the bits will only be the last few bits
-        transfer_bit_buffer = power_of_two[transfer_bit_num] - 1;
-        
-        *out_c <<= transfer_bit_num;
-        *out_c |= new_c & transfer_bit_buffer;
-
-        *out_c_num += transfer_bit_num;
+    // move the whole bytes to the buffer, highest first
+    while (bw->acc_bits >= 8){
+        bw->acc_bits -= 8;
+        bw->buffer[bw->buffer_len++] = (unsigned char) (bw->acc >> bw->acc_bits);
+
+        if (bw->buffer_len == IO_BUFFER_SIZE){
+            fwrite(bw->buffer, 1, bw->buffer_len, bw->fp);
+            bw->buffer_len = 0;
+        }
     }
 
     return;
@@ -209,27 +309,37 @@ void print_to_file(FILE* fp_out, char* out_c, int* out_c_num, int new_c, int new
 
 
 /*************************************************************/
-void pad_last_bit(FILE* fp_out, char* out_c, int* out_c_num){
+void bit_writer_flush(BitWriter bw){
+    assert(bw != NULL);
+
+    fwrite(bw->buffer, 1, bw->buffer_len, bw->fp);
+    bw->buffer_len = 0;
+    return;
+}
+
+
+/*************************************************************/
+void pad_last_bit(BitWriter bw, int rescale_bits){
     // pad last bit and print out
     // and then move to the first byte of the FILE and redo the first byte
+    int pad_num = 0;
 
-    if(*out_c_num != 0){
-        if (*out_c_num == 8){
-            putc(*out_c, fp_out);
-            // the first byte is initially set to 0, so no need to change
-        }
-        else{
-            // need to pad
-            int pad_num = 8 - *out_c_num;
-            *out_c <<= pad_num;
-            putc(*out_c, fp_out);
-            fseek(fp_out, 0, SEEK_SET);
-
-            // so if 3 numbers are padded, output 00000011
-            // if four numbers are padded, output 00000100
-            // easier for decompression
-            putc(pad_num, fp_out);
-        }
+    if (bw->acc_bits != 0){
+        // need to pad
+        pad_num = 8 - bw->acc_bits;
+        print_to_file(bw, 0, pad_num);
+    }
+
+    // write all the buffer
+    bit_writer_flush(bw);
+
+    if (pad_num != 0 || rescale_bits != 0){
+        // so if 3 numbers are padded, output 00000011
+        // if four numbers are padded, output 00000100
+        // easier for decompression
+        // the first byte is initially set to 0, so no need to change otherwise
+        fseek(bw->fp, 0, SEEK_SET);
+        putc(pad_num | rescale_bits << PAD_BITS, bw->fp);
     }
 
     return;
@@ -244,171 +354,254 @@ void decompress_file(FILE* fp, FILE* fp_out, Tree tr){
     // the first byte of file tells how many numbers are padded
     // example: 00000100 means 4 numbers are padded
     //          00000011 means three numbers are padded 
+    // and the rescale bits of the encoder above them
     int pad_num = getc(fp);
+    int rescale_bits = (pad_num == EOF) ? 0 : pad_num >> PAD_BITS;
+    pad_num &= (1 << PAD_BITS) - 1;
 
-    // the second byte is the first letter
-    int buffer1 = getc(fp);
-    // the first letter needs to be printed out, and insert into the tree
-    putc(buffer1, fp_out);
-
-    // insert into the tree
-    Node newNYT = NodeCreate(NYT_C, tr->NYT->label-2, 0, NULL, NULL, tr->NYT);
-    Node newNode = NodeCreate(buffer1, tr->NYT->label-1, 1, NULL, NULL, tr->NYT);
-    // rearrange the link from top-down
-    tr->NYT->left = newNYT;
-    tr->NYT->right = newNode;
-    // reset the NYT
-    tr->NYT = newNYT;
-    // update the tree
-    // since the old NYT is the root node, so just add 1
-    tr->root->occ += 1;
-
-
-    // read the next char
-    buffer1 = getc(fp);
-    int buffer1_num_not_read = 8;
-    int mask;
-    int this_bit;
-
-    // read a further char
-    int buffer2 = getc(fp);
-
-    // node
-    Node n = tr->root;
-
-    while (buffer2 != EOF){
-        // extract one bit
-        mask = 1 << (buffer1_num_not_read - 1);
-        this_bit = ((mask & buffer1) >> (buffer1_num_not_read - 1)) & 1;
-
-        if (this_bit == 0){            
-            n = n->left;
+    if (rescale_bits != 0){
+        if (rescale_bits < RESCALE_MIN_BITS || rescale_bits > RESCALE_MAX_BITS){
+            fprintf(stderr, "Decompress Error: not a valid .FGK file\n");
+            exit(EXIT_FAILURE);
         }
-        else{
-            n = n->right;
+        TreeSetRescale(tr, rescale_bits);
+    }
+
+    BitReader br = bit_reader_create(fp, pad_num);
+    BitWriter bw = bit_writer_create(fp_out);
+
+    decode_symbols(br, bw, tr);
+
+    bit_writer_flush(bw);
+    bit_writer_destroy(bw);
+    bit_reader_destroy(br);
+
+    return;
+}
+
+
+/*************************************************************/
+void decompress_stream(BitReader br, FILE* fp_out){
+    assert(br != NULL && fp_out != NULL);
+
+    // the byte after STREAM_MARK is the rescale bits
+    if (bit_reader_fill(br, 8) < 8){
+        fprintf(stderr, "Decompress Error: the stream is cut\n");
+        exit(EXIT_FAILURE);
+    }
+    int rescale_bits = bit_reader_get(br, 8);
+
+    Tree tr = TreeCreate();
+    if (rescale_bits != 0){
+        if (rescale_bits < RESCALE_MIN_BITS || rescale_bits > RESCALE_MAX_BITS){
+            fprintf(stderr, "Decompress Error: not a valid FGK stream\n");
+            exit(EXIT_FAILURE);
         }
+        TreeSetRescale(tr, rescale_bits);
+    }
+
+    BitWriter bw = bit_writer_create(fp_out);
+
+    decode_symbols(br, bw, tr);
+
+    bit_writer_flush(bw);
+    fflush(fp_out);
+    bit_writer_destroy(bw);
+    TreeDestroy(tr);
+
+    return;
+}
+
 
-        // reduce the number un-readed
-        buffer1_num_not_read -= 1;
+/*************************************************************/
+void decode_symbols(BitReader br, BitWriter bw, Tree tr){
+    assert(br != NULL && bw != NULL && tr != NULL);
+
+    // walk from the root, the first char is read at the root, 
+    // since the root is also the NYT at the start
+    int n = 0;
+    int available;
+    int used;
+    uint64_t bits;
+
+    while (true){
+        // a live stream: write out what is decoded before waiting for input
+        if (br->fp == NULL && br->buffer_pos == br->buffer_len){
+            bit_writer_flush(bw);
+            fflush(bw->fp);
+        }
 
-        // move forward if buffer 1 all readed
-        if (buffer1_num_not_read == 0){
-            buffer1 = buffer2;
-            buffer1_num_not_read = 8;
+        available = bit_reader_fill(br, 1);
+        if (available == 0){
+            break;
+        }
 
-            buffer2 = getc(fp);
-            // here does not need to worry about buffer2 = EOF
+        // walk down with the bits in the register, 1 = right child, 0 = left
+        bits = br->acc;
+        used = 0;
+        while (used < available && tr->nodes[n].child != NO_NODE){
+            n = tr->nodes[n].child + 1 - (int) (bits >> 63);
+            bits <<= 1;
+            used++;
         }
+        bit_reader_skip(br, used);
 
+        // not a leaf yet, read more bits
+        // at the end of file, these are the padded bits and the loop stops
+        if (tr->nodes[n].child != NO_NODE){
+            continue;
+        }
 
-        // if reach NYT node, read the next 8 bits
         if (n == tr->NYT){
-            // read the next 8 bits
-            // first shift buffer1
-            buffer1 <<= 8 - buffer1_num_not_read;
-
-            // then extract some bits from buffer2
-            // need "8 - buffer_1_num_not_read" bits
-            mask = power_of_two[8 - buffer1_num_not_read] - 1;
-            // but this mask needs to be shifted to the leftmost position
-            // and put it to the end of buffer1, in the rightmost position
-            buffer1 |= (((mask << buffer1_num_not_read) & buffer2) >> buffer1_num_not_read) & mask;
-
-            // now buffer1 store the whole 8 bits
-            putc(buffer1, fp_out);
-
-            // insert into the tree
-            Node newNYT = NodeCreate(NYT_C, tr->NYT->label-2, 0, NULL, NULL, tr->NYT);
-            Node newNode = NodeCreate(buffer1, tr->NYT->label-1, 1, NULL, NULL, tr->NYT);
-            
-            // rearrange the oldNYT connection parts
-            tr->NYT->left = newNYT;
-            tr->NYT->right = newNode;
-            tr->NYT->occ += 1;
-
-            // so right now, the separation of old NYT to two new nodes have been finished
-            // also the old NYT weight has been increased
-            // reassign the NYT
-            tr->NYT = newNYT;
-
-            // check if it is the root node
-            // if the old NYT is the root node, do nothing, do not need to update tree any further
-            if(tr->NYT->parent->c != ROOT_C){
-                tr->NYT->parent->c = INTERNAL_NODE_C;
-                // go to its parent node for further update
-                TreeUpdateFunction(tr, NULL, tr->NYT->parent->parent); 
-            }          
-
-            // once finish, move n to the root node
-            n = tr->root;
-
-            // move the remaining bit of buffer2 to buffer1
-            mask = power_of_two[buffer1_num_not_read] - 1;
-            buffer1 = 0;
-            buffer1 |= mask & buffer2;
-            // and buffer1_num_not_read remains the same
-
-            // read next byte
-            buffer2 = getc(fp);        
+            // a new char: the next 8 bits
+            if (bit_reader_fill(br, 8) < 8){
+                break;
+            }
+            int c = bit_reader_get(br, 8);
+
+            // an old char after the NYT is the end of a stream
+            if (tr->leaf[c] != NO_NODE){
+                break;
+            }
+            print_to_file(bw, c, 8);
+
+            // insert into the tree, and update it
+            TreeAddChar(tr, c);
         }
-        else if (n->c >= 0){
+        else{
             // reach a leaf node, not NYT
-            // print the byte
-            putc(n->c, fp_out);
+            print_to_file(bw, tr->nodes[n].c, 8);
 
             // also update the tree: first swap and then increment
-            TreeUpdateFunction(tr, NULL, n);
-            
-            // move n to the root
-            n = tr->root;
+            TreeUpdateFunction(tr, n);
         }
 
-        // if node n is an internal node, then keep going on
+        // move n to the root
+        n = 0;
     }
 
+    return;
+}
 
-    // now buffer2 = EOF, and buffer1 is the last byte, need to use pad_num
-    // read the last few byte
-    int stop_at_this_num;
 
-    if (pad_num == 0){
-        stop_at_this_num = 0;
-    }
-    else{
-        stop_at_this_num = pad_num;
-    }
+/*************************************************************/
+BitReader bit_reader_create(FILE* fp, int pad_num){
+    assert(fp != NULL);
+    assert(pad_num >= 0 && pad_num < 8);
 
+    BitReader br = (BitReader) malloc(sizeof(struct _BitReader));
+    assert(br != NULL);
 
-    // loop to scan the last few bits
-    while (buffer1_num_not_read > stop_at_this_num){
-        // read one bit
-        mask = 1 << (buffer1_num_not_read - 1);
-        this_bit = ((mask & buffer1) >> (buffer1_num_not_read - 1)) & 1;
+    br->fp = fp;
+    br->fd = -1;
+    br->acc = 0;
+    br->acc_bits = 0;
+    br->buffer_len = 0;
+    br->buffer_pos = 0;
+    br->eof = false;
+    br->pad_num = pad_num;
 
-        if (this_bit == 0){
-            n = n->left;
-        }
-        else{
-            n = n->right;
-        }
+    return br;
+}
 
-        buffer1_num_not_read -= 1;
 
-        // so only max 8 bits left, don't need to worry about NYT issue
-        // for internal node, do nothing
-        if (n->c >= 0){
-            // reach a leaf node, not NYT
-            // print the byte
-            putc(n->c, fp_out);
+/*************************************************************/
+BitReader bit_reader_create_fd(int fd){
+    assert(fd >= 0);
+
+    BitReader br = (BitReader) malloc(sizeof(struct _BitReader));
+    assert(br != NULL);
+
+    br->fp = NULL;
+    br->fd = fd;
+    br->acc = 0;
+    br->acc_bits = 0;
+    br->buffer_len = 0;
+    br->buffer_pos = 0;
+    br->eof = false;
+    br->pad_num = 0;
+
+    return br;
+}
 
-            // also update the tree: first swap and then increment
-            TreeUpdateFunction(tr, NULL, n);
-            
-            // move n to the root
-            n = tr->root;
+
+/*************************************************************/
+BitReader bit_reader_destroy(BitReader br){
+    assert(br != NULL);
+
+    free(br);
+    br = NULL;
+    return br;
+}
+
+
+/*************************************************************/
+int bit_reader_fill(BitReader br, int need){
+    // load whole bytes while there is room for them
+    while (br->acc_bits <= 56){
+        if (br->buffer_pos == br->buffer_len){
+            if (br->eof){
+                break;
+            }
+
+            if (br->fp != NULL){
+                br->buffer_len = fread(br->buffer, 1, IO_BUFFER_SIZE, br->fp);
+            }
+            else if (br->acc_bits >= need){
+                // do not wait, there is enough to go on
+                break;
+            }
+            else{
+                // take what is there, read() does not wait for a full buffer
+                int len;
+                do {
+                    len = read(br->fd, br->buffer, IO_BUFFER_SIZE);
+                } while (len < 0 && errno == EINTR);
+
+                br->buffer_len = (len < 0) ? 0 : len;
+            }
+
+            br->buffer_pos = 0;
+            if (br->buffer_len == 0){
+                // the padded bits at the end are not data
+                br->eof = true;
+                break;
+            }
         }
+
+        br->acc |= (uint64_t) br->buffer[br->buffer_pos++] << (56 - br->acc_bits);
+        br->acc_bits += 8;
+    }
+
+    if (br->eof){
+        return (br->acc_bits > br->pad_num) ? br->acc_bits - br->pad_num : 0;
+    }
+    return br->acc_bits;
+}
+
+
+/*************************************************************/
+void bit_reader_skip(BitReader br, int num){
+    assert(num >= 0 && num <= br->acc_bits);
+
+    // a shift of 64 is not defined
+    if (num == 64){
+        br->acc = 0;
     }
+    else{
+        br->acc <<= num;
+    }
+    br->acc_bits -= num;
 
     return;
 }
 
+
+/*************************************************************/
+int bit_reader_get(BitReader br, int num){
+    assert(num >= 1 && num <= 32 && num <= br->acc_bits);
+
+    int result = (int) (br->acc >> (64 - num));
+    bit_reader_skip(br, num);
+    return result;
+}
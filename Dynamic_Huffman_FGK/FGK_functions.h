@@ -11,15 +11,117 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
+#include <stdint.h>
+
+
+// bytes of one fwrite of the bit writer and of one fread of the bit reader,
+// the same block as LZW and Vitter
+#define IO_BUFFER_SIZE (1 << 17)
+
+
+// bit writer: the bits are packed msb first into a 64 bits accumulator,
+// whole bytes go to the buffer, and the full buffer is written at once
+struct _BitWriter{
+    FILE* fp;
+    uint64_t acc;               // pending bits, the valid ones are the lowest acc_bits
+    int acc_bits;               // always < 8 between two calls
+    unsigned char buffer[IO_BUFFER_SIZE];
+    int buffer_len;
+};
+typedef struct _BitWriter* BitWriter;
+
+
+// the first byte of a .FGK file: the number of padded bits (0-7) in the
+// lowest PAD_BITS bits, and the rescale bits of the tree above them,
+// 0 for the default (RESCALE_DEFAULT_BITS). the first bytes it never
+// makes are the marks of the other formats, see container.h
+#define PAD_BITS 3
+
+
+// a stream (from stdin to stdout) can not go back to the first byte, so it
+// starts with STREAM_MARK and a byte of the rescale bits (0 = default).
+// the end is the NYT code followed by a char that is already in the tree,
+// and then 0 bits up to the byte. the marks are in container.h
+#define STREAM_MARK 0xFE
+
+
+// bit reader: the reverse, whole bytes are loaded from a large fread buffer
+// into a 64 bits accumulator, the next bit to read is the highest one.
+// the reader uses fd instead of fp when fp is NULL: then it only waits
+// for more input when the caller needs more bits, for a live stream
+struct _BitReader{
+    FILE* fp;
+    int fd;
+    uint64_t acc;
+    int acc_bits;
+    unsigned char buffer[IO_BUFFER_SIZE];
+    int buffer_len;
+    int buffer_pos;
+    bool eof;                   // the file is read to the end
+    int pad_num;                // padded bits in the last byte, not data
+};
+typedef struct _BitReader* BitReader;
 
 
 // compression and decompression main functions
-void FGK_compress(const char* filename);
-void FGK_decompress(const char* filename);
+// rescale_bits = 0 for the default
+// chunk_size > 0 for a container of chunks, coded by "threads" threads
+void FGK_compress(const char* filename, int rescale_bits, long chunk_size, int threads);
+void FGK_decompress(const char* filename, int threads);
+
+
+// streams: read fd (usually stdin) and write fp_out (usually stdout).
+// the output is written as soon as each read is coded, for live streams
+void FGK_stream_compress(int fd, FILE* fp_out, int rescale_bits);
+void FGK_stream_decompress(int fd, FILE* fp_out);
+
+
+// compress fp to fp_out with one tree, as a whole .FGK file
+void compress_file(FILE* fp, FILE* fp_out, int rescale_bits);
+
+// forward declaration, the tree is in tree.h
+struct _Tree;
+
+// decompress file main function
+// read a char, update the tree and then output related chars. 
+void decompress_file(FILE* fp, FILE* fp_out, struct _Tree* tr);
+
+// the streaming format after STREAM_MARK, up to the end mark
+void decompress_stream(BitReader br, FILE* fp_out);
+
+// the main loop of both formats: decode until the end of the data
+// or the end mark of a stream
+void decode_symbols(BitReader br, BitWriter bw, struct _Tree* tr);
+
+
+// bit writer create / destroy, destroy does not write anything,
+// call pad_last_bit first
+BitWriter bit_writer_create(FILE* fp_out);
+BitWriter bit_writer_destroy(BitWriter);
+
+// write the whole bytes in the buffer
+void bit_writer_flush(BitWriter bw);
+
+// bit reader create / destroy, pad_num from the first byte of the file
+BitReader bit_reader_create(FILE* fp, int pad_num);
+// a reader of a file descriptor, there is no padding to skip
+BitReader bit_reader_create_fd(int fd);
+BitReader bit_reader_destroy(BitReader);
 
+// load as many bits as possible, and return the number of data bits
+// in the accumulator, 0 at the end of the data.
+// a fd reader only waits for input while it has less than "need" bits
+int bit_reader_fill(BitReader br, int need);
+// drop the next "num" bits, they must be in the accumulator
+void bit_reader_skip(BitReader br, int num);
+// read the next "num" bits (max 32), they must be in the accumulator
+int bit_reader_get(BitReader br, int num);
 
 // bit operation
-void print_to_file(FILE* fp_out, char* out_c, int* out_c_num, int new_c, int new_c_num);
-void pad_last_bit(FILE* fp_out, char* out_c, int* out_c_num);
+// print the lowest "num" bits of "bits", msb first, num <= 64
+void print_to_file(BitWriter bw, uint64_t bits, int num);
+// pad the last byte with 0, write everything, and then the number of
+// padded bits and the rescale bits into the first byte of the file
+void pad_last_bit(BitWriter bw, int rescale_bits);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "tree.h"
+#include "FGK_functions.h"
+#include "chunk.h"
+
+
+// the FGK coder of one chunk, param is the rescale bits
+void compress_one_chunk(FILE* in, FILE* out, const void* param);
+void decompress_one_chunk(FILE* in, FILE* out);
+
+
+/*************************************************************/
+void chunk_compress(FILE* fp, FILE* fp_out, long chunk_size, int threads, int rescale_bits){
+    struct _ChunkCoder coder = {compress_one_chunk, decompress_one_chunk, &rescale_bits, ".FGK"};
+
+    container_compress(fp, fp_out, chunk_size, threads, &coder);
+    return;
+}
+
+
+/*************************************************************/
+void chunk_decompress(FILE* fp, FILE* fp_out, int threads){
+    struct _ChunkCoder coder = {compress_one_chunk, decompress_one_chunk, NULL, ".FGK"};
+
+    container_decompress(fp, fp_out, threads, &coder);
+    return;
+}
+
+
+/*************************************************************/
+void compress_one_chunk(FILE* in, FILE* out, const void* param){
+    assert(param != NULL);
+
+    compress_file(in, out, *(const int*) param);
+    return;
+}
+
+
+/*************************************************************/
+void decompress_one_chunk(FILE* in, FILE* out){
+    // a new tree for each chunk
+    Tree tr = TreeCreate();
+    decompress_file(in, out, tr);
+    TreeDestroy(tr);
+    return;
+}
@@ -0,0 +1,21 @@
+// Container of chunks (../Dynamic_Huffman_Common/container.h), with FGK:
+// each chunk is coded with a new tree, as a whole .FGK file of its own.
+
+
+#ifndef _CHUNK_H_
+#define _CHUNK_H_
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../Dynamic_Huffman_Common/container.h"
+
+
+// compress fp into chunks, "threads" chunks are coded at the same time
+void chunk_compress(FILE* fp, FILE* fp_out, long chunk_size, int threads, int rescale_bits);
+
+// decompress the chunks, CHUNK_MARK is already read
+void chunk_decompress(FILE* fp, FILE* fp_out, int threads);
+
+
+#endif
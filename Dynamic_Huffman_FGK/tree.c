@@ -7,66 +7,62 @@
 
 
 // additional function to print the tree in inorder
-void TreeShowFunction(Node root);
+void TreeShowFunction(Tree tr, int n);
 
+// get an unused block / give it back
+int BlockCreate(Tree tr, int leader);
+void BlockDestroy(Tree tr, int b);
 
-// among all nodes with the same occ, return the node pointer with the max label
-Node FindNodeNumberMaxInBlock(Node root, int occ);
+// swap the content of node n with node target, both in the same block
+void TreeSwap(Tree tr, int n, int target);
 
+// increase the occ of node n, which must be the leader of its block,
+// and move it to the block of occ + 1
+void TreeIncrement(Tree tr, int n);
 
-Node NodeCreate(int c, int label, int occ, Node left, Node right, Node parent){
-    // first create the node
-    Node n = (Node) malloc(sizeof(struct _Node));
-    assert(n != NULL);
+// give every node a block again, after the tree is built
+void TreeBuildBlocks(Tree tr);
 
-    // fill information
-    n->c = c;
-    n->label = label;
-    n->occ = occ;
-    n->left = left;
-    n->right = right;
-    n->parent = parent;
+// qsort compare of two long
+int CompareLong(const void* a, const void* b);
 
-    return n;
-}
 
+// upward trace until reach root, the bits are added on the top of the code
+// so the code is already in printing order, no need to reverse it
+int NodeCode(Tree tr, int n, uint64_t* code, int* top){
+    assert(tr != NULL && n != NO_NODE);
+    uint64_t bits = 0;
+    int len = 0;
+
+    while (n != 0 && len < 64){
+        int parent = tr->nodes[n].parent;
 
-Node NodeDestroy(Node n){
-    // recursive delete the children first, then delete this node
-    if (n != NULL){
-        NodeDestroy(n->left);
-        NodeDestroy(n->right);
-        
-        // now free
-        free(n);
-        n = NULL;
+        // right = 1, left = 0
+        if (n == tr->nodes[parent].child){
+            bits |= (uint64_t) 1 << len;
+        }
+        len++;
+        n = parent;
     }
 
-    return n;
+    *code = bits;
+    *top = n;
+    return len;
 }
 
 
-// recursion, upward trace until reach root
-void NodePrintCode(Node n, FILE* fp_out, char* out_c, int* out_c_num){
-    assert(n != NULL);
+void NodePrintCode(Tree tr, int n, BitWriter bw){
+    uint64_t code;
+    int top;
+    int len = NodeCode(tr, n, &code, &top);
 
-    // stop when reach the root
-    if (n->c != ROOT_C){
-        // if not root node yet, continue upwards
-        NodePrintCode(n->parent, fp_out, out_c, out_c_num);
-        
-        // check left or right child
-        if (n == n->parent->left){
-            // left = 0, only print 1 bit
-            print_to_file(fp_out, out_c, out_c_num, 0, 1);
-        }
-        else{
-            // right = 1, only print 1 bit
-            print_to_file(fp_out, out_c, out_c_num, 1, 1);
-        }
-        
+    // more than 64 levels: print the upper part of the path first
+    // (only for a node count of about fib(64), but be safe)
+    if (top != 0){
+        NodePrintCode(tr, top, bw);
     }
 
+    print_to_file(bw, code, len);
     return;
 }
 
@@ -74,10 +70,29 @@ void NodePrintCode(Node n, FILE* fp_out, char* out_c, int* out_c_num){
 Tree TreeCreate(void){
     Tree tr = (Tree) malloc(sizeof(struct _Tree));
     assert(tr != NULL);
-    
+
+    for (int i = 0; i < ALPHABET_SIZE; i++){
+        tr->leaf[i] = NO_NODE;
+    }
+
+    // all blocks are unused
+    tr->free_block_num = 0;
+    for (int i = NODE_NUMBER - 1; i >= 0; i--){
+        tr->free_blocks[tr->free_block_num++] = i;
+    }
+
     // create the root node, and initially this node is also the NYT
-    tr->root = NodeCreate(ROOT_C, LABEL_START, 0, NULL, NULL, NULL);
-    tr->NYT = tr->root;
+    tr->node_num = 1;
+    tr->NYT = 0;
+
+    Node root = &tr->nodes[0];
+    root->occ = 0;
+    root->c = ROOT_C;
+    root->parent = NO_NODE;
+    root->child = NO_NODE;
+    root->block = BlockCreate(tr, 0);
+
+    TreeSetRescale(tr, RESCALE_DEFAULT_BITS);
 
     return tr;
 }
@@ -85,8 +100,8 @@ Tree TreeCreate(void){
 
 Tree TreeDestroy(Tree tr){
     assert(tr != NULL);
-    NodeDestroy(tr->root);
 
+    // the nodes are part of the tree
     free(tr);
     tr = NULL;
     return tr;
@@ -95,267 +110,409 @@ Tree TreeDestroy(Tree tr){
 
 void TreeShow(Tree tr){
     assert(tr != NULL);
-    
-    TreeShowFunction(tr->root);
+
+    TreeShowFunction(tr, 0);
     fprintf(stdout, "\n");
 
     return;
 }
 
 
+void TreeSetRescale(Tree tr, int bits){
+    assert(tr != NULL);
+    assert(bits >= RESCALE_MIN_BITS && bits <= RESCALE_MAX_BITS);
+
+    tr->rescale_limit = 1 << bits;
+    return;
+}
+
+
 // inorder traversal of the tree: left -> root -> right
-void TreeShowFunction(Node n){
-    if (n != NULL){
-        // left 
-        TreeShowFunction(n->left);
-
-        // middle root
-        if (n->c == ROOT_C){
-            fprintf(stdout, "(Root,%d,%d) ", n->label, n->occ);
-        }
-        else if (n->c == INTERNAL_NODE_C){
-            fprintf(stdout, "(Internal,%d,%d) ", n->label, n->occ);
-        }
-        else if(n->c == NYT_C){
-            fprintf(stdout, "(NYT,%d,%d) ", n->label, n->occ);
-        }
-        else{
-            fprintf(stdout, "(%c,%d,%d) ", n->c, n->label, n->occ);
-        }
+void TreeShowFunction(Tree tr, int n){
+    Node nd = &tr->nodes[n];
+    int label = LABEL_START - n;
 
-        // right
-        TreeShowFunction(n->right);
+    // left
+    if (nd->child != NO_NODE){
+        TreeShowFunction(tr, nd->child + 1);
+    }
+
+    // middle root
+    if (nd->c == ROOT_C){
+        fprintf(stdout, "(Root,%d,%d) ", label, nd->occ);
+    }
+    else if (nd->c == INTERNAL_NODE_C){
+        fprintf(stdout, "(Internal,%d,%d) ", label, nd->occ);
+    }
+    else if(nd->c == NYT_C){
+        fprintf(stdout, "(NYT,%d,%d) ", label, nd->occ);
+    }
+    else{
+        fprintf(stdout, "(%c,%d,%d) ", nd->c, label, nd->occ);
+    }
+
+    // right
+    if (nd->child != NO_NODE){
+        TreeShowFunction(tr, nd->child);
     }
 
     return;
 }
 
 
-void TreeUpdate(Tree tr, NodeList ndlist, int c, FILE* fp_out, char *out_c, int* out_c_num){
+void TreeUpdate(Tree tr, int c, BitWriter bw){
     assert(tr != NULL);
-    assert(ndlist != NULL);
 
-    // first determine if the list contain the node or not
-    Node n = NodeListFindNode(ndlist, c);
-    if (n != NULL){
+    // first determine if the tree contain the node or not
+    int n = tr->leaf[c];
+    if (n != NO_NODE){
         // not first occurrence for this letter
-        NodePrintCode(n, fp_out, out_c, out_c_num);
+        NodePrintCode(tr, n, bw);
         // node has been created before
-        TreeUpdateFunction(tr, ndlist, n);
+        TreeUpdateFunction(tr, n);
     }
     else{
         // first occurrence for this letter
-        // print the code for NYT
-        NodePrintCode(tr->NYT, fp_out, out_c, out_c_num);
-        // and also print the new char, the new char has 8 bit
-        print_to_file(fp_out, out_c, out_c_num, c, 8);
-
-        // n is empty, create the node first
-        // n->label = current NYT label - 1
-        // n->parent = current NYT
-        n = NodeCreate(c, tr->NYT->label-1, 1, NULL, NULL, tr->NYT);
-        NodeListAddNode(ndlist, n);
-
-        Node newNYT = NodeCreate(NYT_C, tr->NYT->label-2, 0, NULL, NULL, tr->NYT);
-
-        // rearrange the oldNYT connection parts
-        tr->NYT->left = newNYT;
-        tr->NYT->right = n;
-        tr->NYT->occ += 1;
-
-        // so right now, the separation of old NYT to two new nodes have been finished
-        // also the old NYT weight has been increased
-        // reassign the NYT
-        tr->NYT = newNYT;
-
-        // check if it is the root node
-        // if the old NYT is the root node, do nothing, do not need to update tree any further
-        if(tr->NYT->parent->c != ROOT_C){
-            tr->NYT->parent->c = INTERNAL_NODE_C;
-            // go to its parent node for further update
-            TreeUpdateFunction(tr, ndlist, tr->NYT->parent->parent); 
+        // print the code for NYT, and also the new char, the new char has 8 bit
+        // both in one go when the code is short enough
+        uint64_t code;
+        int top;
+        int len = NodeCode(tr, tr->NYT, &code, &top);
+        if (top == 0 && len <= 56){
+            print_to_file(bw, code << 8 | c, len + 8);
+        }
+        else{
+            NodePrintCode(tr, tr->NYT, bw);
+            print_to_file(bw, c, 8);
         }
+
+        TreeAddChar(tr, c);
+    }
+
+    return;
+}
+
+
+void TreePrintEnd(Tree tr, BitWriter bw){
+    assert(tr != NULL);
+
+    // nothing was sent, the end of the file is enough
+    if (tr->NYT == 0){
+        return;
+    }
+
+    // a char after the NYT is always new, so an old one marks the end
+    int c = 0;
+    while (tr->leaf[c] == NO_NODE){
+        c++;
+    }
+
+    NodePrintCode(tr, tr->NYT, bw);
+    print_to_file(bw, c, 8);
+    return;
+}
+
+
+void TreeAddChar(Tree tr, int c){
+    assert(tr != NULL && tr->leaf[c] == NO_NODE);
+    assert(tr->node_num + 2 <= NODE_NUMBER);
+
+    // the old NYT gets the leaf of c as right child (label - 1)
+    // and the new NYT as left child (label - 2)
+    int old_NYT = tr->NYT;
+    int n = tr->node_num;
+
+    // the old NYT weight is increased first, it is alone in the block of 0
+    TreeIncrement(tr, old_NYT);
+
+    Node leaf = &tr->nodes[n];
+    leaf->occ = 1;
+    leaf->c = c;
+    leaf->parent = old_NYT;
+    leaf->child = NO_NODE;
+    // same occ as the old NYT, just below it
+    leaf->block = tr->nodes[old_NYT].block;
+    tr->leaf[c] = n;
+
+    Node NYT = &tr->nodes[n + 1];
+    NYT->occ = 0;
+    NYT->c = NYT_C;
+    NYT->parent = old_NYT;
+    NYT->child = NO_NODE;
+    NYT->block = BlockCreate(tr, n + 1);
+
+    tr->nodes[old_NYT].child = n;
+    tr->node_num += 2;
+    tr->NYT = n + 1;
+
+    // check if it is the root node
+    // if the old NYT is the root node, do nothing, do not need to update tree any further
+    if (old_NYT != 0){
+        tr->nodes[old_NYT].c = INTERNAL_NODE_C;
+        // go to its parent node for further update
+        TreeUpdateFunction(tr, tr->nodes[old_NYT].parent);
     }
 
     return;
 }
 
 
-void TreeUpdateFunction(Tree tr, NodeList ndlist, Node n){
+void TreeUpdateFunction(Tree tr, int n){
     // tree and the node should not be null
-    // but nodelist can be null (when decompression)
-    assert(tr != NULL && n != NULL);
-    Node target;
-
-    while (n->c != ROOT_C){     
-        // check if its node number is max in the block
-        // traversal the whole tree
-        target = FindNodeNumberMaxInBlock(tr->root, n->occ);    
-
-        // there are 3 possible results: 
-        //  1. target = n->parent, 2. target is null, 3. target is purely different
-        
-        // if yes, ignore, if not do the swap
-        if (target == n->parent || target == NULL){
-            // increase weight
-            n->occ += 1;
-            // move to its parent level
-            n = n->parent;
+    assert(tr != NULL && n != NO_NODE);
+    int target;
+
+    while (n != 0){
+        // the max label node with the same occ
+        target = tr->leader[tr->nodes[n].block];
+
+        if (target == tr->nodes[n].parent){
+            // n and its parent are the top of the block, so the other child
+            // is the NYT. do not swap, and the parent is then the max of its
+            // own block: both are increased, the parent first so that the
+            // block leader moves down to n
+            assert(n == target + 1);
+            TreeIncrement(tr, target);
+            TreeIncrement(tr, n);
+
+            // the parent is done, move to the next level
+            if (target == 0){
+                if (tr->nodes[0].occ >= tr->rescale_limit){
+                    TreeRescale(tr);
+                }
+                return;
+            }
+            n = tr->nodes[target].parent;
         }
         else{
-            // swap: three scenario
-            //      swap internal node with internal
-            //      swap internal with leaf
-            //      swap leaf with leaf
-
-            // so we need to notice that
-            // if simply break and re-construct from bottom up, is not enough
-            // also need to reconstrct from top to down
-            Node n_old_parent = n->parent;
-            Node target_old_parent = target->parent;
-
-            // first break from top to down
-            // the label may be not continuous, so need to use pointer comparison
-            if(n == n_old_parent->right){
-                // n is the right child
-                n_old_parent->right = target;
-            }
-            else{
-                // n is the left child
-                n_old_parent->left = target;
+            // swap with the max label node, then increase the occ
+            if (target != n){
+                TreeSwap(tr, n, target);
             }
 
-            // same as the target side
-            if(target == target_old_parent->right){
-                target_old_parent->right = n;
-            }
-            else{
-                target_old_parent->left = n;
-            }
+            // n is now at the place of target, increase and move to its parent
+            TreeIncrement(tr, target);
+            n = tr->nodes[target].parent;
+        }
+    }
 
-            // the above are top-down approach, now finish the bottom up
-            n->parent = target_old_parent;
-            target->parent = n_old_parent;
+    // for the root node, only need to update the counter
+    TreeIncrement(tr, 0);
 
-            // finally, swap the label
-            int tmp_label;
-            tmp_label = n->label;
-            n->label = target->label;
-            target->label = tmp_label;
+    if (tr->nodes[0].occ >= tr->rescale_limit){
+        TreeRescale(tr);
+    }
 
+    return;
+}
 
-            // and remember to update the node list, for compression
-            if (ndlist != NULL){
-                if (n->c >= 0){
-                    ndlist[n->c] = n;
-                }
 
-                if (target->c >= 0){
-                    ndlist[target->c] = target;
-                }
-            }
+void TreeSwap(Tree tr, int n, int target){
+    Node a = &tr->nodes[n];
+    Node b = &tr->nodes[target];
+    assert(a->occ == b->occ && target != 0);
 
+    // the place in the tree (parent, occ, block) stays with the entry,
+    // only the char and the subtree below are exchanged
+    int tmp;
+    tmp = a->c;
+    a->c = b->c;
+    b->c = tmp;
 
-            // at last, increase the occ of n, and move to its parent
-            n->occ += 1;
-            n = n->parent;
-        }
+    tmp = a->child;
+    a->child = b->child;
+    b->child = tmp;
+
+    // now the children and the node list point to the new places
+    if (a->child != NO_NODE){
+        tr->nodes[a->child].parent = n;
+        tr->nodes[a->child + 1].parent = n;
+    }
+    else if (a->c >= 0){
+        tr->leaf[a->c] = n;
     }
 
-    // for the root node, only need to update the counter
-    n->occ += 1;
+    if (b->child != NO_NODE){
+        tr->nodes[b->child].parent = target;
+        tr->nodes[b->child + 1].parent = target;
+    }
+    else if (b->c >= 0){
+        tr->leaf[b->c] = target;
+    }
 
     return;
 }
 
 
-Node FindNodeNumberMaxInBlock(Node root, int occ){
-    Node result = NULL;
+void TreeIncrement(Tree tr, int n){
+    Node nd = &tr->nodes[n];
+    int b = nd->block;
+    assert(tr->leader[b] == n);
 
-    // use the idea that: occ decreases when going deeper, same as the label
-    if (root != NULL){
-        if (root->occ == occ){
-            // does not need to go deeper
-            // since child's node number definitely smaller than root node number
-            result = root;
+    nd->occ += 1;
+
+    // the node above has an occ >= the new occ, join its block if equal
+    int new_block = NO_NODE;
+    if (n > 0 && tr->nodes[n - 1].occ == nd->occ){
+        new_block = tr->nodes[n - 1].block;
+    }
+
+    // leave the old block, the next node becomes its leader
+    if (n + 1 < tr->node_num && tr->nodes[n + 1].block == b){
+        tr->leader[b] = n + 1;
+        if (new_block == NO_NODE){
+            new_block = BlockCreate(tr, n);
         }
-        else if (root->occ < occ){
-            result = NULL;
+    }
+    else{
+        // n was alone, keep the block if there is no one to join
+        if (new_block == NO_NODE){
+            new_block = b;
         }
         else{
-            // now root->occ > occ
-            // go deeper
-            Node left_max = FindNodeNumberMaxInBlock(root->left, occ);
-            Node right_max = FindNodeNumberMaxInBlock(root->right, occ);
-
-            // if one solution is null or both is null
-            if(left_max == NULL && right_max == NULL){
-                result = NULL;
-            }
-            else if (left_max == NULL){
-                result = right_max;
-            }
-            else if (right_max == NULL){
-                result = left_max;
-            }
-            else{
-                // both are not null
-                // for the same occ, return the max label node
-                // the label number must be different
-                if (left_max->label > right_max->label){
-                    result = left_max;
-                }
-                else if (left_max->label < right_max->label){
-                    result = right_max;
-                }
-                else{
-                    fprintf(stderr, "label number same error\n");
-                    exit(EXIT_FAILURE);
-                }
-            }
+            BlockDestroy(tr, b);
         }
     }
 
-    return result;
+    nd->block = new_block;
+    return;
 }
 
 
+int BlockCreate(Tree tr, int leader){
+    assert(tr->free_block_num > 0);
 
-NodeList NodeListCreate(void){
-    NodeList ndlist = (NodeList) malloc(ALPHABET_SIZE * sizeof(Node));
-    assert(ndlist != NULL);
+    int b = tr->free_blocks[--tr->free_block_num];
+    tr->leader[b] = leader;
+    return b;
+}
 
-    // null every entry
-    for (int i = 0; i < ALPHABET_SIZE; i++){
-        ndlist[i] = NULL;
-    }
 
-    return ndlist;
+void BlockDestroy(Tree tr, int b){
+    assert(tr->free_block_num < NODE_NUMBER);
+
+    tr->free_blocks[tr->free_block_num++] = b;
+    return;
 }
 
 
-NodeList NodeListDestroy(NodeList ndlist){
-    assert(ndlist != NULL);
+// build the tree again the same way as the static huffman tree, but with
+// two queues: the leaves sorted by occ, and the new internal nodes, which
+// come out in increasing occ by themselves. the nodes taken out get the
+// labels from the bottom up, so the occ never decreases in label order,
+// and the two nodes taken together are siblings next to each other.
+// the NYT (occ 0) is taken first, so it is the last node and a left child.
+// on the same occ the internal node is taken first, so the parent of
+// the NYT is right above its sibling, as the update expects
+void TreeRescale(Tree tr){
+    assert(tr != NULL);
+
+    // the leaves: occ in the high bits and the char in the low 8 bits,
+    // the NYT is added in front
+    long keys[ALPHABET_SIZE];
+    int leaf_num = 0;
+    for (int c = 0; c < ALPHABET_SIZE; c++){
+        if (tr->leaf[c] != NO_NODE){
+            long occ = (tr->nodes[tr->leaf[c]].occ + 1) / 2;
+            keys[leaf_num++] = (occ << 8) | c;
+        }
+    }
+    qsort(keys, leaf_num, sizeof(long), CompareLong);
+
+    // internal nodes queue: occ, and the right child
+    int queue_occ[ALPHABET_SIZE];
+    int queue_child[ALPHABET_SIZE];
+    int queue_head = 0;
+    int queue_tail = 0;
+
+    int n = tr->node_num - 1;
+    int next_leaf = -1;             // -1 = the NYT
+    int taken = 0;
+    int first_occ = 0;
+    Node nd;
+
+    // 2 * leaf_num + 1 nodes to take out, the last one is the root
+    while (n >= 0){
+        nd = &tr->nodes[n];
+
+        if (next_leaf < leaf_num && (queue_head == queue_tail 
+            || (next_leaf == -1 ? 0 : keys[next_leaf] >> 8) < queue_occ[queue_head])){
+            // take a leaf
+            if (next_leaf == -1){
+                nd->occ = 0;
+                nd->c = NYT_C;
+                tr->NYT = n;
+            }
+            else{
+                nd->occ = keys[next_leaf] >> 8;
+                nd->c = keys[next_leaf] & 0xFF;
+                tr->leaf[nd->c] = n;
+            }
+            nd->child = NO_NODE;
+            next_leaf++;
+        }
+        else{
+            // take an internal node
+            nd->occ = queue_occ[queue_head];
+            nd->c = INTERNAL_NODE_C;
+            nd->child = queue_child[queue_head];
+            tr->nodes[nd->child].parent = n;
+            tr->nodes[nd->child + 1].parent = n;
+            queue_head++;
+        }
+
+        // every two nodes make a new internal node
+        taken++;
+        if (taken % 2 == 1){
+            first_occ = nd->occ;
+        }
+        else{
+            queue_occ[queue_tail] = first_occ + nd->occ;
+            queue_child[queue_tail] = n;
+            queue_tail++;
+        }
+
+        n--;
+    }
+
+    tr->nodes[0].c = ROOT_C;
+    tr->nodes[0].parent = NO_NODE;
 
-    // at the time to destroy ndlist, the tree should already be destroyed
-    // so no need to call NodeDestroy to all entries
-    free(ndlist);
-    ndlist = NULL;
-    return ndlist;
+    TreeBuildBlocks(tr);
+    return;
 }
 
 
-void NodeListAddNode(NodeList ndlist, Node n){
-    assert(ndlist != NULL);
-    assert(n != NULL && n->c != ROOT_C && n->c != INTERNAL_NODE_C);
+void TreeBuildBlocks(Tree tr){
+    // all blocks are unused
+    tr->free_block_num = 0;
+    for (int i = NODE_NUMBER - 1; i >= 0; i--){
+        tr->free_blocks[tr->free_block_num++] = i;
+    }
+
+    // a new block starts at each change of occ
+    for (int i = 0; i < tr->node_num; i++){
+        if (i == 0 || tr->nodes[i].occ != tr->nodes[i - 1].occ){
+            tr->nodes[i].block = BlockCreate(tr, i);
+        }
+        else{
+            tr->nodes[i].block = tr->nodes[i - 1].block;
+        }
+    }
 
-    ndlist[n->c] = n;
     return;
 }
 
 
-Node NodeListFindNode(NodeList ndlist, int c){
-    assert(ndlist != NULL);
-    // if no node for that char, then return NULL
-    return ndlist[c];
-}
\ No newline at end of file
+int CompareLong(const void* a, const void* b){
+    long x = *(const long*) a;
+    long y = *(const long*) b;
+
+    if (x < y){
+        return -1;
+    }
+    else if (x > y){
+        return 1;
+    }
+    return 0;
+}
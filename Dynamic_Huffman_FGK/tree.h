@@ -10,6 +10,8 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <stdint.h>
+#include "FGK_functions.h"
 
 
 // so the leaf node has char c >= 0
@@ -25,20 +27,36 @@
 #define ALPHABET_SIZE 256
 
 
-// a typical node structure for the dynamic huffman tree
-// as a binary tree, it has left and right child.
-// in order to trace upwards, it has a parent pointer.
-// in addition, the node should contain "label" and "occ" used in swap.
-// and also use integer to represent the char.
-// "int" data type for char, so we can use negative integer to represent 
-// the root and all internal nodes, as well as NYT
+// a full tree has 256 leaves, 255 internal nodes (with the root) and the NYT
+#define NODE_NUMBER (2 * ALPHABET_SIZE + 1)
+
+// no node / no child
+#define NO_NODE -1
+
+
+// rescale: when the root occ reaches 1 << bits, the occ of every leaf is
+// halved and the tree is built again, so the occ never overflows and old
+// statistics fade out. the default keeps files below 1 GB as they were
+#define RESCALE_DEFAULT_BITS 30
+#define RESCALE_MIN_BITS 9
+#define RESCALE_MAX_BITS 30
+
+
+// the nodes live in a fixed array of the tree, indexed by label:
+// node i has label LABEL_START - i, so the root is node 0 and the NYT is
+// always the last node. a swap exchanges the content of two entries, the
+// entries (the labels) stay in place.
+// the two children of a node are always next to each other: the right
+// child is "child", the left child is "child + 1".
+// in label order the occ never decreases, so all nodes with the same occ
+// make a block of consecutive entries, and the block keeps its leader,
+// the node with the max label. "block" is the index of the block.
 struct _Node {
-    int label;
     int occ;
-    int c; 
-    struct _Node *left;
-    struct _Node *right;
-    struct _Node *parent;
+    int c;
+    int parent;
+    int child;          // right child, NO_NODE for a leaf and the NYT
+    int block;
 };
 
 
@@ -46,10 +64,22 @@ struct _Node {
 typedef struct _Node *Node;
 
 
-// dynamic huffman FGK tree structure, store the root and current NYT node. 
+// dynamic huffman FGK tree structure
 struct _Tree{
-    Node root;
-    Node NYT;
+    struct _Node nodes[NODE_NUMBER];
+    int node_num;                   // number of nodes used, NYT = node_num - 1
+    int NYT;
+
+    // node of each char, NO_NODE if not seen yet
+    // in stead of trasversing the tree every time to find the node of a particular char
+    int leaf[ALPHABET_SIZE];
+
+    // blocks: leader of each block, and a stack of the unused blocks
+    int leader[NODE_NUMBER];
+    int free_blocks[NODE_NUMBER];
+    int free_block_num;
+
+    int rescale_limit;              // root occ that triggers a rescale
 };
 
 
@@ -57,33 +87,33 @@ struct _Tree{
 typedef struct _Tree *Tree;
 
 
-// alphabet node list, size = 256 for ascii table
-// only used in compression to increase execution speed
-// in stead of trasversing the tree every time to find the node of a particular char
-typedef Node* NodeList;
-
-
-// node related create and destroy functions
-Node NodeCreate(int c, int label, int occ, Node left, Node right, Node parent);
-Node NodeDestroy(Node);
-// function to output the code for this node, use recursion to trace upwards
-void NodePrintCode(Node n, FILE* fp_out, char* out_c, int* out_c_num);
+// the code of node n, collected in one walk up to the root: the bit of the
+// root is the highest one, the bit of n the lowest.
+// return the code length, or stop at 64 bits and give the node reached in *top
+int NodeCode(Tree tr, int n, uint64_t* code, int* top);
+// function to output the code for this node
+void NodePrintCode(Tree tr, int n, BitWriter bw);
 
 
 // tree related functions
-Tree TreeCreate(void);      
+Tree TreeCreate(void);
 Tree TreeDestroy(Tree);
 void TreeShow(Tree);
-// update the tree: each time swap with the max label node in the block
-void TreeUpdate(Tree, NodeList, int c, FILE* fp_out, char *out_c, int* out_c_num);
-void TreeUpdateFunction(Tree tr, NodeList ndlist, Node n);
-
-
-// node list related functions
-NodeList NodeListCreate(void);
-NodeList NodeListDestroy(NodeList);
-void NodeListAddNode(NodeList, Node);
-Node NodeListFindNode(NodeList, int c);
-
-
-#endif 
+// rescale when the root occ reaches 1 << bits
+void TreeSetRescale(Tree, int bits);
+// halve the occ of every leaf (at least 1) and build the tree again,
+// the encoder and the decoder get the same tree
+void TreeRescale(Tree);
+// print the code of c, and update the tree
+void TreeUpdate(Tree, int c, BitWriter bw);
+// end of a stream: the NYT code and then a char that is already in the tree,
+// nothing if the tree is still empty
+void TreePrintEnd(Tree, BitWriter bw);
+// first occurrence of c: split the NYT into a new NYT and the leaf of c,
+// and update the tree
+void TreeAddChar(Tree, int c);
+// update the tree from node n: each time swap with the max label node in the block
+void TreeUpdateFunction(Tree tr, int n);
+
+
+#endif
@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "compress.h"
+#include "decompress.h"
+#include "chunk.h"
+
+
+// the options of compress_file_and_output, the same for every chunk
+struct _ChunkParam{
+    int rescale_bits;
+    int symbol_bits;
+    int period_bits;
+};
+
+
+// the Vitter coder of one chunk
+void compress_one_chunk(FILE* in, FILE* out, const void* param);
+void decompress_one_chunk(FILE* in, FILE* out);
+
+
+/*************************************************************/
+void chunk_compress(FILE* fp, FILE* fp_out, long chunk_size, int threads, int rescale_bits, int symbol_bits, int period_bits){
+    struct _ChunkParam param = {rescale_bits, symbol_bits, period_bits};
+    struct _ChunkCoder coder = {compress_one_chunk, decompress_one_chunk, &param, ".v"};
+
+    container_compress(fp, fp_out, chunk_size, threads, &coder);
+    return;
+}
+
+
+/*************************************************************/
+void chunk_decompress(FILE* fp, FILE* fp_out, int threads){
+    struct _ChunkCoder coder = {compress_one_chunk, decompress_one_chunk, NULL, ".v"};
+
+    container_decompress(fp, fp_out, threads, &coder);
+    return;
+}
+
+
+/*************************************************************/
+void compress_one_chunk(FILE* in, FILE* out, const void* param){
+    assert(param != NULL);
+
+    const struct _ChunkParam* p = (const struct _ChunkParam*) param;
+    compress_file_and_output(in, out, p->rescale_bits, p->symbol_bits, p->period_bits);
+    return;
+}
+
+
+/*************************************************************/
+void decompress_one_chunk(FILE* in, FILE* out){
+    // decompress_file_and_output makes its own tree
+    decompress_file_and_output(in, out);
+    return;
+}
@@ -0,0 +1,24 @@
+/*
+* Container of chunks (../Dynamic_Huffman_Common/container.h), with Vitter:
+* each chunk is coded with a new tree, as a whole .v file of its own.
+*/
+
+
+#ifndef _CHUNK_H_
+#define _CHUNK_H_
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../Dynamic_Huffman_Common/container.h"
+
+
+// compress fp into chunks, "threads" chunks are coded at the same time.
+// the chunk size is a multiple of 1 KB, so a 16 bits symbol is never cut
+void chunk_compress(FILE* fp, FILE* fp_out, long chunk_size, int threads, int rescale_bits, int symbol_bits, int period_bits);
+
+// decompress the chunks, CHUNK_MARK is already read
+void chunk_decompress(FILE* fp, FILE* fp_out, int threads);
+
+
+#endif
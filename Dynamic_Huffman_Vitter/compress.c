@@ -4,15 +4,12 @@
 #include <assert.h>
 #include <stdbool.h>
 #include "tree.h"
-#include "list.h"
-#include "dictionary.h"
 #include "file.h"
 #include "update.h"
+#include "deferred.h"
 #include "compress.h"
 
 
-// pack the update function, include printing process
-void update_and_print(Tree tr, List L, Dictionary d, int* buffer_p, int* buffer_len_p, int c, FILE* fp);
 
 
 // add .v suffix
@@ -29,53 +26,79 @@ char* compression_create_output_filename(char* filename_in){
 }
 
 
-void compress_file_and_output(FILE* fp_in, FILE* fp_out){
+void compress_file_and_output(FILE* fp_in, FILE* fp_out, int rescale_bits, int symbol_bits, int period_bits){
     assert(fp_in != NULL && fp_out != NULL);
+    assert(symbol_bits == SYMBOL_BITS_DEFAULT || symbol_bits == SYMBOL_BITS_WIDE);
 
-    // create the tree, dictionary and the list
-    Tree tr = TreeCreate();
-    List L = ListCreate();
-    Dictionary d = DictionaryCreate(ASCII_SIZE);
+    // create the tree
+    Tree tr = TreeCreate(1 << symbol_bits);
+    if (rescale_bits != 0){
+        TreeSetRescale(tr, rescale_bits);
+    }
+
+    // a wide file has its header before the stream,
+    // the bytes left at the end are filled in later
+    long start = 0;
+    if (symbol_bits != SYMBOL_BITS_DEFAULT){
+        FilePrintWideHeader(fp_out, symbol_bits, 0, 0);
+        start = WIDE_HEADER_SIZE;
+    }
 
-    // buffer for print
-    // when reach 8, print the byte
-    int buffer = 0;
-    int buffer_len = 0;
+    // the deferred update, with its header
+    Deferred d = NULL;
+    if (period_bits != 0){
+        d = DeferredCreate(tr, period_bits);
+        DeferredPrintHeader(fp_out, period_bits);
+        start += DEFERRED_HEADER_SIZE;
+    }
 
     // before reading the first char
     // print a byte to output file first, later used to record num of digits pad
     FilePrintEmptyByte(fp_out);
 
-    // for the first char, build the tree and list naively
-    int c = getc(fp_in);
-    TreeUpdateForFirstChar(tr, c);
-    ListNode first_char_LN = ListUpdateForFirstChar(L, tr);
-    DictionaryInsert(d, first_char_LN);
-    FilePrintByte(&buffer, &buffer_len, fp_out, c);
+    // the codes go through the bit writer
+    BitWriter bw = BitWriterCreate(fp_out);
 
-    // debug
-    // printf("After first char = %c %d\n", c, c);
-    // TreeShow(tr);
-    // ListShow(L);
-    // printf("\n");
-
-
-    // read and compress
+    // read and compress, a symbol is made of symbol_bits / 8 bytes
+    int symbol_bytes = symbol_bits / 8;
+    int symbol = 0;
+    int len = 0;
+    int c;
     while ((c=getc(fp_in)) != EOF){
-        // debug
-        // printf("Insert char = %c %d\n", c, c);
-        update_and_print(tr, L, d, &buffer, &buffer_len, c, fp_out);
+        symbol = (symbol << 8) | c;
+        len += 1;
+
+        if (len == symbol_bytes){
+            // debug
+            // printf("Insert symbol = %d\n", symbol);
+            if (d != NULL){
+                DeferredPrint(d, bw, symbol);
+            }
+            else{
+                update_and_print(tr, bw, symbol);
+            }
+            symbol = 0;
+            len = 0;
+        }
     }
 
     // at the end, pad the file
-    int num_pad = FilePrintPad(&buffer, &buffer_len, fp_out);
-    FileRePrintFirstByte(num_pad, fp_out);
+    int num_pad = FilePrintPad(bw);
+    FileRePrintFirstByte(num_pad, rescale_bits, start, fp_out);
+
+    // and keep the bytes left in the header
+    if (len != 0){
+        fseek(fp_out, 0, SEEK_SET);
+        FilePrintWideHeader(fp_out, symbol_bits, len, symbol);
+    }
 
 
     // clean everything
+    if (d != NULL){
+        DeferredDestroy(d);
+    }
+    BitWriterDestroy(bw);
     TreeDestroy(tr);
-    ListDestroy(L);
-    DictionaryDestroy(d, ASCII_SIZE);
 
     return;
 }
@@ -99,35 +122,25 @@ void compression_status(char* name_in, char* name_out, FILE* fp_in, FILE* fp_out
 }
 
 
-void update_and_print(Tree tr, List L, Dictionary d, int* buffer_p, int* buffer_len_p, int c, FILE* fp){
-    assert(tr != NULL && L != NULL && d != NULL);
-    assert(buffer_p != NULL && buffer_len_p != NULL && (*buffer_len_p) >= 0 && (*buffer_len_p)<8);
-    assert(c >= 0);
-    assert(fp != NULL);
-    
-
-    // find the listnode of the symbol
-    // the symbol can be new, or existing
-    ListNode LN_p = DictionarySearch(d, c);
-    
-
-    // for new symbol
-    if (LN_p == NULL){
-        // printf("new symbol\n");
+void update_and_print(Tree tr, BitWriter bw, int c){
+    assert(tr != NULL && bw != NULL);
+    assert(c >= 0 && c < tr->alphabet);
 
-        LN_p = GetListNode(L, GetNYT(tr));
-
-        FilePrintNodePath(buffer_p, buffer_len_p, fp, GetTreeNode(LN_p));
-        
-        FilePrintByte(buffer_p, buffer_len_p, fp, c);
+    if (tr->node_num == 0){
+        // the first symbol: the root is the NYT, so just the symbol
+        FilePrintBits(bw, c, tr->symbol_bits);
+    }
+    else if (tr->rep[c] == NO_NODE){
+        // new symbol: the path of the NYT, and the symbol
+        FilePrintNodePath(bw, tr, tr->NYT);
+        FilePrintBits(bw, c, tr->symbol_bits);
     }
     else{
-        // printf("existing symbol\n");
         // existing symbol, print the trace only
-        FilePrintNodePath(buffer_p, buffer_len_p, fp, GetTreeNode(LN_p));
+        FilePrintNodePath(bw, tr, tr->rep[c]);
     }
 
     // call the main update function
-    UpdateTreeAndList(tr, L, d, LN_p, c);
+    UpdateTree(tr, c);
     return;
-}
\ No newline at end of file
+}
@@ -10,8 +10,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "tree.h"
-#include "list.h"
-#include "dictionary.h"
 #include "file.h"
 #include "update.h"
 
@@ -21,7 +19,15 @@ char* compression_create_output_filename(char* filename_in);
 
 
 // main function for compression
-void compress_file_and_output(FILE* fp_in, FILE* fp_out);
+// rescale_bits = 0 for the default of the tree
+// symbol_bits = SYMBOL_BITS_DEFAULT for bytes, or SYMBOL_BITS_WIDE
+// period_bits = 0 to update the code at every symbol, or the deferred update
+void compress_file_and_output(FILE* fp_in, FILE* fp_out, int rescale_bits, int symbol_bits, int period_bits);
+
+
+// code one symbol of the alphabet of the tree and update the tree, so the
+// tree can also code the symbols of another stage, like the tokens of a LZ pass
+void update_and_print(Tree tr, BitWriter bw, int c);
 
 
 // print both file names, and calculate the compression ratio
@@ -3,19 +3,25 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
-#include <math.h>
 #include "tree.h"
-#include "list.h"
-#include "dictionary.h"
 #include "update.h"
 #include "file.h"
+#include "deferred.h"
 #include "decompress.h"
 
 
-// additional function for compression
-// get next bit, or next 1 byte (8 bits)
-int GetOneBit(int* c_p, int* unread_num_p, int* c_next_p, FILE* fp);
-int GetOneByte(int* c_p, int* unread_num_p, int* c_next_p, FILE* fp);
+// additional function for decompression
+// the symbol of the next code, or of the NYT code and the symbol after it
+int DecodeOneSymbol(Tree tr, BitReader br);
+// a new symbol of symbol_bits, 8 or 16
+int ReadOneSymbol(Tree tr, BitReader br);
+
+
+// decode the stream after the first byte, into the symbols of the tree
+void decode_symbols(Tree tr, BitWriter bw, FILE* fp_in, int pad_number);
+
+// the same with the code of the deferred update
+void deferred_decode_symbols(Tree tr, BitWriter bw, FILE* fp_in, int pad_number, int period_bits);
 
 
 // before create the output file name, check if the file is valid
@@ -61,103 +67,124 @@ char* decompression_create_output_filename(char* filename_in){
 void decompress_file_and_output(FILE* fp_in, FILE* fp_out){
     assert(fp_in != NULL && fp_out != NULL);
 
-    // create structure
-    Tree tr = TreeCreate();
-    List L = ListCreate();
-    Dictionary d = DictionaryCreate(ASCII_SIZE);
+    // a wide file starts with its header
+    int symbol_bits = SYMBOL_BITS_DEFAULT;
+    int tail_len = 0;
+    int tail = 0;
 
-    // the first byte records the number of zeros pad at the end
-    int pad_number = getc(fp_in);
+    int first = getc(fp_in);
+    if (first == WIDE_MARK){
+        symbol_bits = getc(fp_in);
+        tail_len = getc(fp_in);
+        tail = getc(fp_in);
 
-    // buffer for reading, c = current, c_next = next byte
-    int c = getc(fp_in);
-    int unread_num;
-    int c_next;
-    
-    // first byte is output straight away
-    putc(c, fp_out);
-    
-    // also update the tree for the first char
-    TreeUpdateForFirstChar(tr, c);
-    ListNode first_char_LN = ListUpdateForFirstChar(L, tr);
-    DictionaryInsert(d, first_char_LN);
+        if (symbol_bits != SYMBOL_BITS_WIDE || tail_len < 0 || tail_len >= symbol_bits / 8 || tail == EOF){
+            fprintf(stderr, "Decompress Error: not a valid .v file\n");
+            exit(EXIT_FAILURE);
+        }
+        first = getc(fp_in);
+    }
 
-    c = getc(fp_in);
-    unread_num = 8;
-    c_next = getc(fp_in);
+    // and the deferred update its header after it
+    int period_bits = 0;
+    if (first == DEFERRED_MARK){
+        period_bits = getc(fp_in);
 
-    int this_bit, this_byte;
-    TreeNode trn = GetRoot(tr);
-    ListNode LN_p = NULL;
+        if (period_bits < PERIOD_MIN_BITS || period_bits > PERIOD_MAX_BITS){
+            fprintf(stderr, "Decompress Error: not a valid .v file\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    else{
+        ungetc(first, fp_in);
+    }
 
-    while (c_next != EOF){
-        this_bit = GetOneBit(&c, &unread_num, &c_next, fp_in);
+    // create structure
+    Tree tr = TreeCreate(1 << symbol_bits);
 
-        if (this_bit == 0){
-            trn = GetLeft(trn);
-        }
-        else{
-            trn = GetRight(trn);
-        }
+    // the first byte records the number of zeros pad at the end,
+    // and the rescale bits of the encoder
+    int pad_number = getc(fp_in);
+    int rescale_bits = pad_number >> PAD_BITS;
+    pad_number &= (1 << PAD_BITS) - 1;
 
-        if (IsNYTNode(trn) || IsSymbolNode(trn)){
-            if (IsNYTNode(trn)){
-                // meet NYT, extract next 8 byte
-                this_byte = GetOneByte(&c, &unread_num, &c_next, fp_in);
-            }
-            else if (IsSymbolNode(trn)){
-                // meet an existing symbol
-                this_byte = GetC(trn);
-            }
-
-            // print it out
-            putc(this_byte, fp_out);
-
-            // update
-            LN_p = GetListNode(L, trn);
-            UpdateTreeAndList(tr, L, d, LN_p, this_byte);
-
-            // treenode back to the beginning
-            trn = GetRoot(tr);
+    if (rescale_bits != 0){
+        if (rescale_bits < RESCALE_MIN_BITS || rescale_bits > RESCALE_MAX_BITS || rescale_bits <= tr->symbol_bits){
+            fprintf(stderr, "Decompress Error: not a valid .v file\n");
+            exit(EXIT_FAILURE);
         }
+        TreeSetRescale(tr, rescale_bits);
     }
 
+    // the output symbols go through the bit writer
+    BitWriter bw = BitWriterCreate(fp_out);
 
-    // now c_next is EOF, so only read remaining parts in c
-    // but read only the number of unread bits minus padded bits
-    int mask = pow(2, unread_num - pad_number) - 1;
-    c &= (mask << pad_number);
-    c >>= pad_number;
-    c &= mask;
+    if (period_bits != 0){
+        deferred_decode_symbols(tr, bw, fp_in, pad_number, period_bits);
+    }
+    else{
+        decode_symbols(tr, bw, fp_in, pad_number);
+    }
 
-    unread_num -= pad_number;
+    // the bytes that do not make a symbol
+    if (tail_len != 0){
+        FilePrintByte(bw, tail);
+    }
 
+    // the output is whole bytes, nothing is padded
+    FilePrintPad(bw);
+    BitWriterDestroy(bw);
+    TreeDestroy(tr);
+    return;
+}
 
-    while (unread_num >= 1){
-        this_bit = GetOneBit(&c, &unread_num, &c_next, fp_in);
 
-        if (this_bit == 0){
-            trn = GetLeft(trn);
-        }
-        else{
-            trn = GetRight(trn);
-        }
+void decode_symbols(Tree tr, BitWriter bw, FILE* fp_in, int pad_number){
+    assert(tr != NULL && bw != NULL && fp_in != NULL);
+
+    BitReader br = BitReaderCreate(fp_in, pad_number);
+
+    // an empty file
+    if (FileReadFill(br) == 0){
+        BitReaderDestroy(br);
+        return;
+    }
 
-        if (IsSymbolNode(trn)){
-            this_byte = GetC(trn);
+    // first symbol is sent as it is
+    int this_symbol = ReadOneSymbol(tr, br);
 
-            // print it out
-            putc(this_byte, fp_out);
+    while (true){
+        // print it out
+        FilePrintBits(bw, this_symbol, tr->symbol_bits);
 
-            // update
-            LN_p = GetListNode(L, trn);
-            UpdateTreeAndList(tr, L, d, LN_p, this_byte);
+        // update
+        UpdateTree(tr, this_symbol);
 
-            // treenode back to the beginning
-            trn = GetRoot(tr);
+        // the padded bits are already dropped, so no bit is left at the end
+        if (FileReadFill(br) == 0){
+            break;
         }
+        this_symbol = DecodeOneSymbol(tr, br);
+    }
+
+    BitReaderDestroy(br);
+    return;
+}
+
+
+void deferred_decode_symbols(Tree tr, BitWriter bw, FILE* fp_in, int pad_number, int period_bits){
+    assert(tr != NULL && bw != NULL && fp_in != NULL);
+
+    Deferred d = DeferredCreate(tr, period_bits);
+    BitReader br = BitReaderCreate(fp_in, pad_number);
+
+    int c;
+    while ((c = DeferredRead(d, br)) != -1){
+        FilePrintBits(bw, c, tr->symbol_bits);
     }
 
+    BitReaderDestroy(br);
+    DeferredDestroy(d);
     return;
 }
 
@@ -185,59 +212,51 @@ bool IsValidFile(char* filename_in){
 }
 
 
-int GetOneBit(int* c_p, int* unread_num_p, int* c_next_p, FILE* fp){
-    assert(c_p != NULL && unread_num_p != NULL && c_next_p != NULL);
-    assert((*unread_num_p) >= 0);
-    assert(fp != NULL);
+int DecodeOneSymbol(Tree tr, BitReader br){
+    assert(tr != NULL && br != NULL);
 
-    // read the bit from left to right
-    int mask = 1 << ((*unread_num_p) - 1);
-    int this_bit = ((mask & (*c_p)) >> ((*unread_num_p) - 1)) & 1;
-    (*unread_num_p) -= 1;
+    // peek a word, walk down the tree and skip the bits used.
+    // a code longer than the word goes on with the next one
+    int n = tr->root;
+    while (! IsLeafNode(tr, n)){
+        int num = FileReadFill(br);
+        if (num == 0){
+            fprintf(stderr, "Decompress Error: not a valid .v file\n");
+            exit(EXIT_FAILURE);
+        }
+        if (num > 57){
+            num = 57;
+        }
 
-    if ((*unread_num_p) == 0 && (*c_next_p) != EOF){
-        (*c_p) = (*c_next_p);
-        (*c_next_p) = getc(fp);
-        (*unread_num_p) = 8;
+        uint64_t word = FilePeekBits(br, num);
+        int used = 0;
+        while (used < num && ! IsLeafNode(tr, n)){
+            used += 1;
+            n = GetChild(tr, n, (word >> (num - used)) & 1);
+        }
+        FileSkipBits(br, used);
     }
 
-    return this_bit;
-}
-
-
-int GetOneByte(int* c_p, int* unread_num_p, int* c_next_p, FILE* fp){
-    assert(c_p != NULL && unread_num_p != NULL && c_next_p != NULL);
-    assert((*unread_num_p) >= 0 && (*unread_num_p) <= 8);
-    assert(fp != NULL);
-
-    // need to extract 8 digits
-    int result;
+    // meet NYT, the next symbol follows
+    if (IsNYTNode(tr, n)){
+        FileReadFill(br);
+        return ReadOneSymbol(tr, br);
+    }
 
-    if ((*unread_num_p) == 8){
-        result = (*c_p);
-        (*unread_num_p) = 0;
+    // meet an existing symbol
+    return tr->nodes[n].c;
+}
 
-        (*c_p) = (*c_next_p);
-        (*c_next_p) = getc(fp);
-        (*unread_num_p) = 8;
-    }
-    else{
-        // get part from *c_p
-        int mask = pow(2, (*unread_num_p)) - 1;
-        result = ((*c_p) & mask);
-        result <<= 8 - (*unread_num_p);
 
-        // and the rest from *c_next_p
-        mask = pow(2, 8-(*unread_num_p)) - 1;
-        int other_part = (*c_next_p) & (mask << (*unread_num_p));
-        other_part >>= (*unread_num_p);
-        other_part &= mask;
-        result |= other_part;
+int ReadOneSymbol(Tree tr, BitReader br){
+    assert(tr != NULL && br != NULL);
 
-        // unread num is still the same
-        (*c_p) = (*c_next_p);
-        (*c_next_p) = getc(fp);
+    if (br->acc_bits < tr->symbol_bits){
+        fprintf(stderr, "Decompress Error: not a valid .v file\n");
+        exit(EXIT_FAILURE);
     }
 
-    return result;
-}
\ No newline at end of file
+    int c = (int) FilePeekBits(br, tr->symbol_bits);
+    FileSkipBits(br, tr->symbol_bits);
+    return c;
+}
@@ -10,8 +10,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "tree.h"
-#include "list.h"
-#include "dictionary.h"
 
 
 // remove .v suffix, and add deVitter_ prefix
@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include "tree.h"
+#include "update.h"
+#include "file.h"
+#include "deferred.h"
+
+
+// count the symbol, and rebuild the code when it is time
+void DeferredCount(Deferred d, int c);
+
+// build the tree from the counts, and the canonical code from the tree
+void DeferredRebuild(Deferred d);
+
+// the symbol of the next code, its bits are dropped
+int DeferredDecode(Deferred d, BitReader br);
+
+// the next symbol_bits bits, a new symbol
+int DeferredReadSymbol(Deferred d, BitReader br);
+
+
+// the length and the symbol of a leaf, in one key for qsort
+#define KEY_SYMBOL_BITS 17
+
+
+/*************************************************************/
+Deferred DeferredCreate(Tree tr, int period_bits){
+    assert(tr != NULL && tr->node_num == 0);
+    assert(period_bits >= PERIOD_MIN_BITS && period_bits <= PERIOD_MAX_BITS);
+
+    Deferred d = (Deferred) malloc(sizeof(struct _Deferred));
+    assert(d != NULL);
+
+    d->tr = tr;
+    d->NYT = tr->alphabet;
+
+    d->occ = (int*) calloc(tr->alphabet, sizeof(int));
+    d->seen = (int*) malloc(tr->alphabet * sizeof(int));
+    d->code = (uint64_t*) malloc((tr->alphabet + 1) * sizeof(uint64_t));
+    d->len = (int*) calloc(tr->alphabet + 1, sizeof(int));
+    d->sorted = (int*) malloc((tr->alphabet + 1) * sizeof(int));
+    d->depth = (int*) malloc(tr->node_number * sizeof(int));
+    assert(d->occ != NULL && d->seen != NULL && d->code != NULL);
+    assert(d->len != NULL && d->sorted != NULL && d->depth != NULL);
+
+    d->seen_num = 0;
+    d->occ_total = 0;
+
+    d->symbol_num = 0;
+    d->next_rebuild = 1;
+    d->period = 1L << period_bits;
+
+    // no code before the first rebuild, the first symbol is sent as it is
+    d->max_len = 0;
+
+    return d;
+}
+
+
+/*************************************************************/
+Deferred DeferredDestroy(Deferred d){
+    assert(d != NULL);
+
+    free(d->occ);
+    free(d->seen);
+    free(d->code);
+    free(d->len);
+    free(d->sorted);
+    free(d->depth);
+    free(d);
+    d = NULL;
+    return d;
+}
+
+
+/*************************************************************/
+void DeferredPrint(Deferred d, BitWriter bw, int c){
+    assert(d != NULL && bw != NULL);
+    assert(c >= 0 && c < d->tr->alphabet);
+
+    if (d->len[c] != 0){
+        FilePrintBits(bw, d->code[c], d->len[c]);
+    }
+    else{
+        // not in the code yet: the NYT code, and the symbol.
+        // a symbol seen after the last rebuild is sent this way again
+        if (d->max_len != 0){
+            FilePrintBits(bw, d->code[d->NYT], d->len[d->NYT]);
+        }
+        FilePrintBits(bw, c, d->tr->symbol_bits);
+    }
+
+    DeferredCount(d, c);
+    return;
+}
+
+
+/*************************************************************/
+int DeferredRead(Deferred d, BitReader br){
+    assert(d != NULL && br != NULL);
+
+    if (FileReadFill(br) == 0){
+        return -1;
+    }
+
+    int c;
+    if (d->max_len == 0){
+        c = DeferredReadSymbol(d, br);
+    }
+    else{
+        c = DeferredDecode(d, br);
+        if (c == d->NYT){
+            FileReadFill(br);
+            c = DeferredReadSymbol(d, br);
+        }
+    }
+
+    DeferredCount(d, c);
+    return c;
+}
+
+
+/*************************************************************/
+int DeferredDecode(Deferred d, BitReader br){
+    // a short code in one look up
+    struct _TableEntry* e = &d->table[FilePeekBits(br, TABLE_BITS)];
+    int symbol = e->symbol;
+    int len = e->len;
+
+    // a longer code: the codes of one length are consecutive numbers
+    if (len == 0){
+        for (int l = TABLE_BITS + 1; l <= d->max_len; l++){
+            uint64_t code = FilePeekBits(br, l);
+            if (code - d->first[l] < (uint64_t) d->count[l]){
+                symbol = d->sorted[d->index[l] + (int) (code - d->first[l])];
+                len = l;
+                break;
+            }
+        }
+    }
+
+    if (len == 0 || len > br->acc_bits){
+        fprintf(stderr, "Decompress Error: not a valid .v file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    FileSkipBits(br, len);
+    return symbol;
+}
+
+
+/*************************************************************/
+int DeferredReadSymbol(Deferred d, BitReader br){
+    int bits = d->tr->symbol_bits;
+
+    if (br->acc_bits < bits){
+        fprintf(stderr, "Decompress Error: not a valid .v file\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int c = (int) FilePeekBits(br, bits);
+    FileSkipBits(br, bits);
+    return c;
+}
+
+
+/*************************************************************/
+// the encoder and the decoder count the same symbols,
+// so they rebuild the same code at the same time
+void DeferredCount(Deferred d, int c){
+    if (d->occ[c] == 0){
+        d->seen[d->seen_num++] = c;
+    }
+    d->occ[c] += 1;
+    d->occ_total += 1;
+
+    // halve the counts as Rescale does, at least 1
+    if (d->occ_total >= d->tr->rescale_limit){
+        d->occ_total = 0;
+        for (int i = 0; i < d->seen_num; i++){
+            int s = d->seen[i];
+            d->occ[s] = (d->occ[s] + 1) / 2;
+            d->occ_total += d->occ[s];
+        }
+    }
+
+    // after 1, 2, 4 ... symbols, and then every period
+    d->symbol_num += 1;
+    if (d->symbol_num == d->next_rebuild){
+        DeferredRebuild(d);
+        d->next_rebuild += (d->symbol_num < d->period) ? d->symbol_num : d->period;
+    }
+
+    return;
+}
+
+
+/*************************************************************/
+void DeferredRebuild(Deferred d){
+    Tree tr = d->tr;
+    int leaf_num = d->seen_num;
+
+    // the tree of the counts, the same as the adaptive tree after a rescale.
+    // the keys of the tree have room for every leaf and the NYT
+    long* keys = tr->keys;
+
+    for (int i = 0; i < leaf_num; i++){
+        int s = d->seen[i];
+        keys[i] = ((long) d->occ[s] << tr->symbol_bits) | s;
+    }
+    qsort(keys, leaf_num, sizeof(long), CompareLong);
+    TreeRebuild(tr, keys, leaf_num);
+
+    // the depth of each position, the parent is always above
+    int* depth = d->depth;
+
+    depth[0] = 0;
+    for (int t = 1; t < tr->node_num; t++){
+        depth[t] = depth[GetPosition(tr, tr->parent_at[t])] + 1;
+    }
+
+    // the leaves by length, and by symbol on the same length
+    int k = 0;
+    for (int t = 1; t < tr->node_num; t++){
+        int n = GetNodeAt(tr, t);
+        if (IsLeafNode(tr, n)){
+            int s = (tr->nodes[n].c == NYT_C) ? d->NYT : tr->nodes[n].c;
+            keys[k++] = ((long) depth[t] << KEY_SYMBOL_BITS) | s;
+        }
+    }
+    assert(k == leaf_num + 1);
+    qsort(keys, k, sizeof(long), CompareLong);
+
+    // canonical code: the next code of the same length is one more,
+    // and a longer code is shifted to its length
+    memset(d->count, 0, sizeof(d->count));
+    uint64_t code = 0;
+    int prev_len = 0;
+
+    for (int i = 0; i < k; i++){
+        int s = (int) (keys[i] & ((1L << KEY_SYMBOL_BITS) - 1));
+        int len = (int) (keys[i] >> KEY_SYMBOL_BITS);
+        assert(len >= 1 && len <= CODE_MAX_BITS);
+
+        if (i > 0){
+            code = (code + 1) << (len - prev_len);
+        }
+        prev_len = len;
+
+        d->code[s] = code;
+        d->len[s] = len;
+        d->sorted[i] = s;
+
+        if (d->count[len] == 0){
+            d->first[len] = code;
+            d->index[len] = i;
+        }
+        d->count[len] += 1;
+    }
+    d->max_len = prev_len;
+
+    // the table: a short code fills all the entries that start with it
+    for (int i = 0; i < (1 << TABLE_BITS); i++){
+        d->table[i].len = 0;
+    }
+
+    for (int i = 0; i < k; i++){
+        int s = d->sorted[i];
+        int len = d->len[s];
+        if (len > TABLE_BITS){
+            break;
+        }
+
+        int start = (int) (d->code[s] << (TABLE_BITS - len));
+        for (int j = start; j < start + (1 << (TABLE_BITS - len)); j++){
+            d->table[j].symbol = s;
+            d->table[j].len = len;
+        }
+    }
+
+    return;
+}
+
+
+/*************************************************************/
+void DeferredPrintHeader(FILE* fp, int period_bits){
+    assert(fp != NULL);
+    assert(period_bits >= PERIOD_MIN_BITS && period_bits <= PERIOD_MAX_BITS);
+
+    fputc(DEFERRED_MARK, fp);
+    fputc(period_bits, fp);
+    return;
+}
@@ -0,0 +1,97 @@
+/*
+* Deferred update: a semi-adaptive mode on top of the tree.
+* The occ of each symbol is counted at every symbol, as in the adaptive
+* coding, but the code only follows the counts every 2^period_bits symbols.
+* Then the tree is built from the counts (TreeRebuild, as in Rescale), and
+* the code lengths of its leaves give a canonical code, which stays fixed
+* until the next rebuild. So the decoder looks the codes up in a table,
+* like a static huffman decoder, instead of walking the tree bit by bit.
+* To start quickly, the code is also rebuilt after 1, 2, 4 ... symbols.
+*/
+
+
+#ifndef _DEFERRED_H_
+#define _DEFERRED_H_
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "tree.h"
+#include "file.h"
+
+
+// the file has DEFERRED_MARK and the period bits before the first byte
+// of the stream, after the wide header if there is one.
+// the marks are in container.h
+#define DEFERRED_MARK 0xFD
+#define DEFERRED_HEADER_SIZE 2
+
+// the code is rebuilt every 2^period_bits symbols
+#define PERIOD_MIN_BITS 8
+#define PERIOD_MAX_BITS 24
+
+// the codes up to TABLE_BITS are decoded by one look up
+#define TABLE_BITS 10
+
+// a code is below 50 bits for a total occ below 2^30, and the bit reader
+// loads 57 bits at least, so one load always holds a whole code
+#define CODE_MAX_BITS 57
+
+
+// one entry of the decode table, len = 0 for a longer code
+struct _TableEntry{
+    int symbol;
+    int len;
+};
+
+
+struct _Deferred{
+    Tree tr;                    // built from occ at each rebuild
+    int NYT;                    // the symbol number of the NYT, tr->alphabet
+
+    // counts of the symbols seen, and the list of them
+    int* occ;
+    int* seen;
+    int seen_num;
+    long occ_total;
+
+    long symbol_num;            // symbols coded
+    long next_rebuild;          // symbol_num of the next rebuild
+    long period;
+
+    // the canonical code of each symbol and the NYT, len = 0 if not in it
+    uint64_t* code;
+    int* len;
+
+    // decode: the table, and for the longer codes the first code, the
+    // number of codes and the first index in sorted of each length
+    struct _TableEntry table[1 << TABLE_BITS];
+    uint64_t first[CODE_MAX_BITS + 1];
+    int count[CODE_MAX_BITS + 1];
+    int index[CODE_MAX_BITS + 1];
+    int* sorted;                // the symbols by code
+    int max_len;
+
+    int* depth;                 // scratch of a rebuild, for each position
+};
+typedef struct _Deferred* Deferred;
+
+
+// create and destroy, the tree belongs to the caller
+Deferred DeferredCreate(Tree tr, int period_bits);
+Deferred DeferredDestroy(Deferred d);
+
+
+// print the code of c, then count it
+void DeferredPrint(Deferred d, BitWriter bw, int c);
+
+// read the next symbol and count it, return -1 at the end of the data
+int DeferredRead(Deferred d, BitReader br);
+
+
+// print the header at the current position
+void DeferredPrintHeader(FILE* fp, int period_bits);
+
+
+#endif
@@ -1,8 +1,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <stdint.h>
 #include "tree.h"
-#include "list.h"
+#include "file.h"
 
 
 FILE* open_the_file(char* filename, char* mode){
@@ -23,73 +24,158 @@ FILE* close_the_file(FILE* fp){
 
 
 
-// single digit
-void FilePrintDigit(int* buffer_p, int* buffer_len_p, FILE* fp, int new_digit){
-    assert(buffer_p != NULL && buffer_len_p != NULL);
+BitWriter BitWriterCreate(FILE* fp){
     assert(fp != NULL);
-    assert(new_digit == 0 || new_digit == 1);
-
-    (*buffer_p) <<= 1;
-    (*buffer_p) |= (new_digit & 1);
-    (*buffer_len_p) += 1;
-
-    // print when 8
-    if (*buffer_len_p == 8){
-        fputc(*buffer_p, fp);
-        
-        // reset
-        (*buffer_p) = 0;
-        (*buffer_len_p) = 0;
-    }
 
-    return;
+    BitWriter bw = (BitWriter) malloc(sizeof(struct _BitWriter));
+    assert(bw != NULL);
+
+    bw->fp = fp;
+    bw->acc = 0;
+    bw->acc_bits = 0;
+    bw->buffer_len = 0;
+
+    return bw;
 }
 
 
-// for new node, print the byte
-void FilePrintByte(int* buffer_p, int* buffer_len_p, FILE* fp, int new_byte){
-    assert(buffer_p != NULL && buffer_len_p != NULL);
-    assert(fp != NULL);
-    assert(new_byte >= 0);
+BitWriter BitWriterDestroy(BitWriter bw){
+    assert(bw != NULL);
+
+    free(bw);
+    bw = NULL;
+    return bw;
+}
 
-    if (*buffer_len_p == 0){
-        fputc(new_byte, fp);
+
+void FilePrintBits(BitWriter bw, uint64_t bits, int num){
+    assert(bw != NULL);
+    assert(num >= 0 && num <= 64);
+    assert(num == 64 || (bits >> num) == 0);
+
+    if (bw->acc_bits + num < 64){
+        bw->acc = (bw->acc << num) | bits;
+        bw->acc_bits += num;
+        return;
     }
-    else{
-        int this_digit;
-        int mask;
-        // input into FilePrintDigit one by one
-        for (int i = 7; i >= 0; i--){
-            mask = 1 << i;
-            this_digit = ((new_byte & mask) >> i) & 1; 
-            FilePrintDigit(buffer_p, buffer_len_p, fp, this_digit);
-        }
+
+    // the register is full: fill it with the highest bits, and keep the rest
+    int free_bits = 64 - bw->acc_bits;
+    int rest = num - free_bits;
+    uint64_t word = (free_bits == 64) ? bits : (bw->acc << free_bits) | (bits >> rest);
+
+    bw->acc = bits & (((uint64_t) 1 << rest) - 1);
+    bw->acc_bits = rest;
+
+    // 8 bytes, highest first
+    for (int i = 56; i >= 0; i -= 8){
+        bw->buffer[bw->buffer_len++] = (unsigned char) (word >> i);
     }
 
+    if (bw->buffer_len > IO_BUFFER_SIZE - 8){
+        fwrite(bw->buffer, 1, bw->buffer_len, bw->fp);
+        bw->buffer_len = 0;
+    }
+
+    return;
+}
+
+
+// for new node, print the byte
+void FilePrintByte(BitWriter bw, int new_byte){
+    assert(new_byte >= 0 && new_byte < 256);
+
+    FilePrintBits(bw, new_byte, 8);
     return;
 }
 
 
 // print the node path from the root node
 // left = 0, right = 1
-void FilePrintNodePath(int* buffer_p, int* buffer_len_p, FILE* fp, TreeNode trn){
-    assert(buffer_p != NULL && buffer_len_p != NULL);
-    assert(fp != NULL);
-    assert(trn != NULL);
-    
-    // recursion, go upwards from the tree first
-    if (trn->parent->c != ROOT_C){
-        FilePrintNodePath(buffer_p, buffer_len_p, fp, trn->parent);
+void FilePrintNodePath(BitWriter bw, Tree tr, int n){
+    assert(bw != NULL);
+    assert(tr != NULL);
+
+    // the whole path in one walk up, in one register
+    uint64_t code;
+    int top;
+    int len = NodeCode(tr, n, &code, &top);
+
+    // a path longer than 64 bits, print the upper part first
+    if (top != 0){
+        FilePrintNodePath(bw, tr, GetNodeAt(tr, top));
     }
 
-    // now trn's parent is the root node
-    if (trn == trn->parent->left){
-        FilePrintDigit(buffer_p, buffer_len_p, fp, 0);
+    FilePrintBits(bw, code, len);
+    return;
+}
+
+
+BitReader BitReaderCreate(FILE* fp, int pad_num){
+    assert(fp != NULL);
+    assert(pad_num >= 0 && pad_num <= 7);
+
+    BitReader br = (BitReader) malloc(sizeof(struct _BitReader));
+    assert(br != NULL);
+
+    br->fp = fp;
+    br->acc = 0;
+    br->acc_bits = 0;
+    br->buffer_len = fread(br->buffer, 1, IO_BUFFER_SIZE, fp);
+    br->buffer_pos = 0;
+    br->pad_num = pad_num;
+
+    return br;
+}
+
+
+BitReader BitReaderDestroy(BitReader br){
+    assert(br != NULL);
+
+    free(br);
+    br = NULL;
+    return br;
+}
+
+
+int FileReadFill(BitReader br){
+    assert(br != NULL);
+
+    while (br->acc_bits <= 56 && br->buffer_pos < br->buffer_len){
+        br->acc = (br->acc << 8) | br->buffer[br->buffer_pos++];
+        br->acc_bits += 8;
+
+        if (br->buffer_pos == br->buffer_len){
+            br->buffer_len = fread(br->buffer, 1, IO_BUFFER_SIZE, br->fp);
+            br->buffer_pos = 0;
+
+            // the last byte is in, drop its padding
+            if (br->buffer_len == 0){
+                br->acc >>= br->pad_num;
+                br->acc_bits -= br->pad_num;
+            }
+        }
     }
-    else{
-        FilePrintDigit(buffer_p, buffer_len_p, fp, 1);
+
+    return br->acc_bits;
+}
+
+
+uint64_t FilePeekBits(BitReader br, int num){
+    assert(br != NULL && num >= 1 && num <= 57);
+
+    uint64_t mask = ((uint64_t) 1 << num) - 1;
+    if (br->acc_bits >= num){
+        return (br->acc >> (br->acc_bits - num)) & mask;
     }
+    return (br->acc << (num - br->acc_bits)) & mask;
+}
 
+
+void FileSkipBits(BitReader br, int num){
+    assert(br != NULL && num >= 0 && num <= br->acc_bits);
+
+    br->acc_bits -= num;
     return;
 }
 
@@ -103,12 +189,27 @@ void FilePrintEmptyByte(FILE* fp){
 }
 
 
-void FileRePrintFirstByte(int num, FILE* fp){
+void FileRePrintFirstByte(int num, int rescale_bits, long pos, FILE* fp){
     assert(num >= 0 && num <= 7);
+    assert(rescale_bits >= 0 && rescale_bits <= RESCALE_MAX_BITS);
+    assert(pos >= 0 && fp != NULL);
+
+    fseek(fp, pos, SEEK_SET);
+    fputc(num | rescale_bits << PAD_BITS, fp);
+
+    return;
+}
+
+
+void FilePrintWideHeader(FILE* fp, int symbol_bits, int tail_len, int tail){
     assert(fp != NULL);
+    assert(symbol_bits == SYMBOL_BITS_WIDE);
+    assert(tail_len >= 0 && tail_len < symbol_bits / 8);
 
-    fseek(fp, 0, SEEK_SET);
-    fputc(num, fp);
+    fputc(WIDE_MARK, fp);
+    fputc(symbol_bits, fp);
+    fputc(tail_len, fp);
+    fputc(tail, fp);
 
     return;
 }
@@ -116,18 +217,22 @@ void FileRePrintFirstByte(int num, FILE* fp){
 
 // for the last byte, need to pad and print to the front
 // return the number of bits pad, should be 0 to 7
-int FilePrintPad(int* buffer_p, int* buffer_len_p, FILE* fp){
-    assert(buffer_p != NULL && buffer_len_p != NULL);
-    assert((*buffer_len_p) >= 0 && (*buffer_len_p) <= 7);
-    assert(fp != NULL);
+int FilePrintPad(BitWriter bw){
+    assert(bw != NULL);
 
-    int pad_num = 0;
+    int pad_num = (8 - bw->acc_bits % 8) % 8;
+    uint64_t acc = bw->acc << pad_num;
+    int acc_bits = bw->acc_bits + pad_num;
 
-    if ((*buffer_len_p) != 0){
-        pad_num = 8 - (*buffer_len_p);
-        (*buffer_p) <<= pad_num;
-        fputc(*buffer_p, fp);
+    // the whole bytes left in the register
+    for (int i = acc_bits - 8; i >= 0; i -= 8){
+        bw->buffer[bw->buffer_len++] = (unsigned char) (acc >> i);
     }
+    bw->acc = 0;
+    bw->acc_bits = 0;
+
+    fwrite(bw->buffer, 1, bw->buffer_len, bw->fp);
+    bw->buffer_len = 0;
 
     return pad_num;
 }
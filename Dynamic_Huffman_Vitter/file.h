@@ -4,8 +4,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include "tree.h"
-#include "list.h"
 
 
 // open and close the file
@@ -13,19 +13,98 @@ FILE* open_the_file(char* filename, char* mode);
 FILE* close_the_file(FILE* fp);
 
 
-// file print: print one bit, one byte or the node path
-void FilePrintDigit(int* buffer_p, int* buffer_len_p, FILE* fp, int new_digit);
-void FilePrintByte(int* buffer_p, int* buffer_len_p, FILE* fp, int new_byte);
-void FilePrintNodePath(int* buffer_p, int* buffer_len_p, FILE* fp, TreeNode trn);
+// bytes of one fwrite of the bit writer and of one fread of the bit reader,
+// the same block as LZW and FGK
+#define IO_BUFFER_SIZE (1 << 17)
+
+
+// bit writer, for the codes of the compression and the bytes of the
+// decompression: the bits are packed msb first into a 64 bits register,
+// the full register goes to the buffer as 8 bytes, and the full buffer is
+// written at once
+struct _BitWriter{
+    FILE* fp;
+    uint64_t acc;               // pending bits, the valid ones are the lowest acc_bits
+    int acc_bits;               // always < 64 between two calls
+    unsigned char buffer[IO_BUFFER_SIZE];
+    int buffer_len;
+};
+typedef struct _BitWriter* BitWriter;
+
+
+// create and destroy, destroy does not write anything,
+// call FilePrintPad first
+BitWriter BitWriterCreate(FILE* fp);
+BitWriter BitWriterDestroy(BitWriter bw);
+
+
+// file print: print the lowest num bits (num <= 64, the bits above are 0),
+// one byte or the node path. a new symbol is printed in tr->symbol_bits
+void FilePrintBits(BitWriter bw, uint64_t bits, int num);
+void FilePrintByte(BitWriter bw, int new_byte);
+void FilePrintNodePath(BitWriter bw, Tree tr, int n);
+
+
+// bit reader, the other way round: the bytes are read into the buffer and
+// loaded msb first into a 64 bits register, so a code can be looked at
+// before it is taken. the padded bits are dropped as soon as the last
+// byte is loaded, so the register only has data bits
+struct _BitReader{
+    FILE* fp;
+    uint64_t acc;               // the valid bits are the lowest acc_bits
+    int acc_bits;
+    unsigned char buffer[IO_BUFFER_SIZE];
+    int buffer_len;
+    int buffer_pos;
+    int pad_num;
+};
+typedef struct _BitReader* BitReader;
+
+
+// create and destroy, pad_num from the first byte of the stream
+BitReader BitReaderCreate(FILE* fp, int pad_num);
+BitReader BitReaderDestroy(BitReader br);
+
+
+// file read: load the register up to 57 bits, fewer at the end of the file,
+// and return the number of bits in it
+int FileReadFill(BitReader br);
+// the next num bits (num <= 57), 0 after the end, and drop them
+uint64_t FilePeekBits(BitReader br, int num);
+void FileSkipBits(BitReader br, int num);
+
+
+// the first byte of a .v file: the number of padded bits (0-7) in the
+// lowest PAD_BITS bits, and the rescale bits of the tree above them,
+// 0 for the default (RESCALE_DEFAULT_BITS). the first bytes it never
+// makes are the marks of the other formats, see container.h
+#define PAD_BITS 3
+
+
+// symbols of 16 bits: the file starts with WIDE_MARK, the symbol bits, the
+// number of bytes left at the end that do not make a symbol (0 or 1) and
+// that byte, then the .v stream of the symbols, which are msb first.
+// the marks are in container.h
+#define WIDE_MARK 0xFE
+#define WIDE_HEADER_SIZE 4
+
+// bytes by default, or 16 bits
+#define SYMBOL_BITS_DEFAULT 8
+#define SYMBOL_BITS_WIDE 16
 
 
 // at the beginning of the file,
 // print one empty byte that will store the number of bits pad at the end 
 void FilePrintEmptyByte(FILE* fp);
-// at the end of file, pad the last byte if necesary and return the number
-int FilePrintPad(int* buffer_p, int* buffer_len_p, FILE* fp);
-// print the number of bytes pad, at the first byte of output file
-void FileRePrintFirstByte(int, FILE* fp);
+// at the end of file, pad the last byte if necesary, write everything
+// and return the number
+int FilePrintPad(BitWriter bw);
+// print the number of bytes pad and the rescale bits, at the first byte of
+// the stream, which is at pos of the output file
+void FileRePrintFirstByte(int num, int rescale_bits, long pos, FILE* fp);
+
+// print the header of a wide file at the current position
+void FilePrintWideHeader(FILE* fp, int symbol_bits, int tail_len, int tail);
 
 
 #endif 
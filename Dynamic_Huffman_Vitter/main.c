@@ -2,6 +2,12 @@
 * Main function.
 * Usage: ./vitter <-d|-c> <input file>
 * -d for decompression, -c for compression
+* options of -c: -r <bits>, to rescale the tree when the total count reaches 2^bits
+*                -s <chunk KB>, to code chunks with a new tree each
+*                -j <threads>, to code the chunks at the same time
+*                -w <bits>, 8 for bytes, or 16 to code 16 bits symbols
+*                -k <bits>, to update the code every 2^bits symbols only
+* option of -d: -j <threads>
 */
 
 
@@ -14,38 +20,107 @@
 #include "update.h"
 #include "compress.h"
 #include "decompress.h"
+#include "chunk.h"
+#include "deferred.h"
 
 
 // top-level compress and decompress functions
 // will call the individual header files
-void compress(char* filename);
-void decompress(char* filename);
+void compress(char* filename, int rescale_bits, long chunk_size, int threads, int symbol_bits, int period_bits);
+void decompress(char* filename, int threads);
+
+// print the usage and exit
+void usage(char* name);
 
 
 // main function
 int main(int argc, char** argv){
-    if (argc != 3){
-        fprintf(stderr, "Usage: %s <-c|-d> <file>\n", argv[0]);
-        exit(EXIT_FAILURE);
+    if (argc < 3 || argc % 2 == 0){
+        usage(argv[0]);
     }
 
-
+    bool is_compress = false;
     if (strcmp(argv[1], "-c") == 0){
-        compress(argv[2]);
+        is_compress = true;
+    }
+    else if (strcmp(argv[1], "-d") != 0){
+        usage(argv[0]);
+    }
+
+    // 0 = default rescale, 0 = no chunks
+    int rescale_bits = 0;
+    long chunk_kb = 0;
+    int threads = 1;
+    int symbol_bits = SYMBOL_BITS_DEFAULT;
+    int period_bits = 0;
+
+    // options come in pairs after the file name
+    for (int i = 3; i < argc; i += 2){
+        if (strcmp(argv[i], "-r") == 0 && is_compress){
+            rescale_bits = atoi(argv[i+1]);
+            if (rescale_bits < RESCALE_MIN_BITS || rescale_bits > RESCALE_MAX_BITS){
+                fprintf(stderr, "rescale bits must be %d to %d\n", RESCALE_MIN_BITS, RESCALE_MAX_BITS);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-s") == 0 && is_compress){
+            chunk_kb = atol(argv[i+1]);
+            if (chunk_kb < 1 || chunk_kb > CHUNK_MAX_KB){
+                fprintf(stderr, "chunk size must be 1 to %d KB\n", CHUNK_MAX_KB);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-w") == 0 && is_compress){
+            symbol_bits = atoi(argv[i+1]);
+            if (symbol_bits != SYMBOL_BITS_DEFAULT && symbol_bits != SYMBOL_BITS_WIDE){
+                fprintf(stderr, "symbol bits must be %d or %d\n", SYMBOL_BITS_DEFAULT, SYMBOL_BITS_WIDE);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-k") == 0 && is_compress){
+            period_bits = atoi(argv[i+1]);
+            if (period_bits < PERIOD_MIN_BITS || period_bits > PERIOD_MAX_BITS){
+                fprintf(stderr, "period bits must be %d to %d\n", PERIOD_MIN_BITS, PERIOD_MAX_BITS);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-j") == 0){
+            threads = atoi(argv[i+1]);
+            if (threads < 1){
+                usage(argv[0]);
+            }
+        }
+        else{
+            usage(argv[0]);
+        }
     }
-    else if (strcmp(argv[1], "-d") == 0){
-        decompress(argv[2]);
+
+    // every symbol keeps occ 1 at least, so the limit must be above the alphabet
+    if (rescale_bits != 0 && rescale_bits <= symbol_bits){
+        fprintf(stderr, "rescale bits must be more than the symbol bits\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (is_compress){
+        compress(argv[2], rescale_bits, chunk_kb * 1024, threads, symbol_bits, period_bits);
     }
     else{
-        fprintf(stderr, "Usage: %s <-c|-d> <file>\n", argv[0]);
-        exit(EXIT_FAILURE);        
+        decompress(argv[2], threads);
     }
 
     return 0;
 }
 
 
-void compress(char* filename_in){
+void usage(char* name){
+    fprintf(stderr, "Usage: %s -c <file> [-r rescale bits, %d-%d] [-s chunk KB] [-j threads] [-w symbol bits, %d or %d] [-k period bits, %d-%d]\n", 
+            name, RESCALE_MIN_BITS, RESCALE_MAX_BITS, SYMBOL_BITS_DEFAULT, SYMBOL_BITS_WIDE, PERIOD_MIN_BITS, PERIOD_MAX_BITS);
+    fprintf(stderr, "       %s -d <file.v> [-j threads]\n", name);
+    exit(EXIT_FAILURE);
+}
+
+
+void compress(char* filename_in, int rescale_bits, long chunk_size, int threads, int symbol_bits, int period_bits){
     assert(filename_in != NULL);
     
     char* filename_out = compression_create_output_filename(filename_in);
@@ -54,8 +129,13 @@ void compress(char* filename_in){
     FILE* fp_in = open_the_file(filename_in, "rb");
     FILE* fp_out = open_the_file(filename_out, "wb");
 
-    // compression
-    compress_file_and_output(fp_in, fp_out);
+    // compression, as one tree or as a container of chunks
+    if (chunk_size > 0){
+        chunk_compress(fp_in, fp_out, chunk_size, threads, rescale_bits, symbol_bits, period_bits);
+    }
+    else{
+        compress_file_and_output(fp_in, fp_out, rescale_bits, symbol_bits, period_bits);
+    }
     
     // print some statistics
     compression_status(filename_in, filename_out, fp_in, fp_out);
@@ -71,14 +151,22 @@ void compress(char* filename_in){
 }
 
 
-void decompress(char* filename){
+void decompress(char* filename, int threads){
     assert(filename != NULL);
     char* filename_out = decompression_create_output_filename(filename);
 
     FILE* fp_in = open_the_file(filename, "rb");
     FILE* fp_out = open_the_file(filename_out, "wb");
 
-    decompress_file_and_output(fp_in, fp_out);
+    // a container of chunks starts with CHUNK_MARK
+    int first = getc(fp_in);
+    if (first == CHUNK_MARK){
+        chunk_decompress(fp_in, fp_out, threads);
+    }
+    else{
+        ungetc(first, fp_in);
+        decompress_file_and_output(fp_in, fp_out);
+    }
 
     decompression_status(filename, filename_out, fp_in, fp_out);
 
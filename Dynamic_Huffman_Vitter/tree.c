@@ -6,44 +6,62 @@
 
 
 // additional function for TreeShow
-void TreeShowFunction(TreeNode);
+void TreeShowFunction(Tree tr, int n);
 
 
-TreeNode TreeNodeCreate(int c, int occ, TreeNode left, TreeNode right, TreeNode parent){
-    TreeNode trn = (TreeNode) malloc(sizeof(struct _TreeNode));
-    assert(trn != NULL);
+Tree TreeCreate(int alphabet){
+    assert(alphabet >= 2 && alphabet <= ALPHABET_MAX);
 
-    trn->c = c;
-    trn->occ = occ;
-    trn->left = left;
-    trn->right = right;
-    trn->parent = parent;
-
-    return trn;
-}
-
-
-// recursive delete children first, then trace upwards
-TreeNode TreeNodeDestroy(TreeNode trn){
-    if (trn != NULL){
-        TreeNodeDestroy(trn->left);
-        TreeNodeDestroy(trn->right);
+    Tree tr = (Tree) malloc(sizeof(struct _Tree));
+    assert(tr != NULL);
 
-        free(trn);
-        trn = NULL;
+    // a new symbol is sent in the fewest bits that hold alphabet - 1
+    tr->alphabet = alphabet;
+    tr->symbol_bits = 1;
+    while ((1 << tr->symbol_bits) < alphabet){
+        tr->symbol_bits++;
     }
 
-    return trn;
-}
-
+    tr->leaf_number = alphabet + 1;
+    tr->node_number = 2 * alphabet + 1;
+    tr->root = tr->node_number - 1;
+
+    tr->nodes = (struct _Node*) malloc(tr->node_number * sizeof(struct _Node));
+    tr->rep = (int*) malloc(alphabet * sizeof(int));
+    tr->block_at = (int*) malloc(tr->node_number * sizeof(int));
+    tr->parent_at = (int*) malloc(tr->node_number * sizeof(int));
+    tr->blocks = (struct _Block*) malloc(tr->node_number * sizeof(struct _Block));
+    tr->free_blocks = (int*) malloc(tr->node_number * sizeof(int));
+    assert(tr->nodes != NULL && tr->rep != NULL && tr->block_at != NULL);
+    assert(tr->parent_at != NULL && tr->blocks != NULL && tr->free_blocks != NULL);
+
+    tr->keys = (long*) malloc(tr->leaf_number * sizeof(long));
+    tr->pos_c = (int*) malloc(tr->node_number * sizeof(int));
+    tr->pos_occ = (int*) malloc(tr->node_number * sizeof(int));
+    tr->pos_child = (int*) malloc(tr->node_number * sizeof(int));
+    tr->node_at = (int*) malloc(tr->node_number * sizeof(int));
+    tr->queue_occ = (int*) malloc(tr->leaf_number * sizeof(int));
+    tr->queue_child = (int*) malloc(tr->leaf_number * sizeof(int));
+    assert(tr->keys != NULL && tr->pos_c != NULL && tr->pos_occ != NULL && tr->pos_child != NULL);
+    assert(tr->node_at != NULL && tr->queue_occ != NULL && tr->queue_child != NULL);
+
+    // empty tree: the root is also the NYT until the first char
+    tr->node_num = 0;
+    tr->NYT = NO_NODE;
+    tr->leaf_low = tr->leaf_number;
+    tr->internal_low = tr->node_number;
+
+    for (int c = 0; c < alphabet; c++){
+        tr->rep[c] = NO_NODE;
+    }
 
-Tree TreeCreate(void){
-    Tree tr = (Tree) malloc(sizeof(struct _Tree));
-    assert(tr != NULL);
+    // all blocks are free, in reverse so that block 0 is taken first
+    for (int i = 0; i < tr->node_number; i++){
+        tr->free_blocks[i] = tr->node_number - 1 - i;
+    }
+    tr->free_block_num = tr->node_number;
 
-    // create the initial root and NYT = root
-    tr->root = TreeNodeCreate(ROOT_C, 0, NULL, NULL, NULL);
-    tr->NYT = tr->root;
+    TreeSetRescale(tr, RESCALE_DEFAULT_BITS);
 
     return tr;
 }
@@ -52,165 +70,148 @@ Tree TreeCreate(void){
 Tree TreeDestroy(Tree tr){
     assert(tr != NULL);
 
-    TreeNodeDestroy(tr->root);
+    free(tr->nodes);
+    free(tr->rep);
+    free(tr->block_at);
+    free(tr->parent_at);
+    free(tr->blocks);
+    free(tr->free_blocks);
+    free(tr->keys);
+    free(tr->pos_c);
+    free(tr->pos_occ);
+    free(tr->pos_child);
+    free(tr->node_at);
+    free(tr->queue_occ);
+    free(tr->queue_child);
     free(tr);
     tr = NULL;
     return tr;
 }
 
 
-bool IsRightChild(TreeNode child, TreeNode parent){
-    assert(child != NULL && parent != NULL);
-    assert(child->parent == parent);
-
-    if (parent->right == child){
-        return true;
-    }
-    else{
-        return false;
-    }
-}
-
-
-// just root tag there is fine
-bool IsRootNode(TreeNode trn){
-    assert(trn != NULL);
-    return trn->c == ROOT_C;
-}
-
+void TreeSetRescale(Tree tr, int bits){
+    assert(tr != NULL);
+    assert(bits >= RESCALE_MIN_BITS && bits <= RESCALE_MAX_BITS);
+    assert(bits > tr->symbol_bits);
 
-bool IsInternalNode(TreeNode trn){
-    assert(trn != NULL);
-    return trn->c == INTERNAL_NODE_C && (trn->left != NULL || trn->right != NULL);
+    tr->rescale_limit = 1 << bits;
+    return;
 }
 
 
-// no child node is enough, cause NYT, root can also be leaf node
-bool IsLeafNode(TreeNode trn){
-    assert(trn != NULL);
-    return trn->left == NULL && trn->right == NULL;
-}
-
+int BlockCreate(Tree tr, int weight, int leader, int size, int top){
+    assert(tr != NULL && tr->free_block_num > 0);
 
-bool IsNYTNode(TreeNode trn){
-    assert(trn != NULL);
-    return IsLeafNode(trn) && trn->c == NYT_C ;
-}
+    tr->free_block_num -= 1;
+    int b = tr->free_blocks[tr->free_block_num];
 
+    tr->blocks[b].weight = weight;
+    tr->blocks[b].leader = leader;
+    tr->blocks[b].size = size;
+    tr->blocks[b].top = top;
 
-bool IsSymbolNode(TreeNode trn){
-    assert(trn != NULL);
-    return IsLeafNode(trn) && trn->c >= 0;
+    return b;
 }
 
 
-bool IsNYTSubling(TreeNode trn){
-    assert(trn != NULL);
-    // must be the right child
-    return IsRightChild(trn, trn->parent) && IsNYTNode(trn->parent->left);
-}
-
+void BlockDestroy(Tree tr, int b){
+    assert(tr != NULL && tr->free_block_num < tr->node_number);
 
-void IncreaseOcc(TreeNode trn){
-    assert(trn != NULL);
-    assert(! IsNYTNode(trn));
-    
-    trn->occ += 1;
+    tr->free_blocks[tr->free_block_num] = b;
+    tr->free_block_num += 1;
     return;
 }
 
 
-void ConnectAsParent(TreeNode child, TreeNode parent){
-    assert(child != NULL && parent != NULL);
-    child->parent = parent;
-    return;
+bool IsLeafNode(Tree tr, int n){
+    assert(tr != NULL && n >= 0 && n < tr->node_number);
+    return n < tr->leaf_number;
 }
 
 
-void ConnectAsRightChild(TreeNode child, TreeNode parent){
-    assert(child != NULL && parent != NULL);
-    parent->right = child;
-    return;
+bool IsRootNode(Tree tr, int n){
+    assert(tr != NULL);
+    return n == tr->root;
 }
 
 
-void ConnectAsLeftChild(TreeNode child, TreeNode parent){
-    assert(child != NULL && parent != NULL);
-    parent->left = child;
-    return;
+bool IsNYTNode(Tree tr, int n){
+    assert(tr != NULL);
+    return n == tr->NYT;
 }
 
 
-void ConnectAsChild(TreeNode child, TreeNode parent, bool isRightChild){
-    assert(child != NULL && parent != NULL);
-    
-    if (isRightChild){
-        parent->right = child;
-    }
-    else{
-        parent->left = child;
-    }
+// the right child, with the NYT as the left child
+bool IsNYTSibling(Tree tr, int n){
+    assert(tr != NULL);
 
-    return;
+    int t = GetPosition(tr, n);
+    return (t & 1) == 1 && t + 1 == tr->node_num - 1;
 }
 
 
-TreeNode GetRoot(Tree tr){
+bool IsRootBlock(Tree tr, int b){
     assert(tr != NULL);
-    return tr->root;
+    return tr->blocks[b].leader == tr->root;
 }
 
 
-TreeNode GetNYT(Tree tr){
+int GetPosition(Tree tr, int n){
     assert(tr != NULL);
-    return tr->NYT;
-}
-
 
-int GetC(TreeNode trn){
-    assert(trn != NULL);
-    return trn->c;
+    struct _Block* bk = &tr->blocks[tr->nodes[n].block];
+    return bk->top + (bk->leader - n);
 }
 
 
-int GetOcc(TreeNode trn){
-    assert(trn != NULL && trn->occ >= 0);
-    return trn->occ;
+int GetNodeAt(Tree tr, int t){
+    assert(tr != NULL && t >= 0 && t < tr->node_num);
+
+    struct _Block* bk = &tr->blocks[tr->block_at[t]];
+    return bk->leader - (t - bk->top);
 }
 
 
-TreeNode GetRight(TreeNode trn){
-    assert(trn != NULL);
-    return trn->right;
+int GetParent(Tree tr, int n){
+    assert(tr != NULL);
+
+    if (IsRootNode(tr, n)){
+        return NO_NODE;
+    }
+    return tr->parent_at[GetPosition(tr, n)];
 }
 
 
-TreeNode GetLeft(TreeNode trn){
-    assert(trn != NULL);
-    return trn->left;
+int GetChild(Tree tr, int n, int bit){
+    assert(tr != NULL && ! IsLeafNode(tr, n));
+    return GetNodeAt(tr, tr->nodes[n].child + 1 - bit);
 }
 
 
-TreeNode GetParent(TreeNode trn){
-    assert(trn != NULL);
-    return trn->parent;
+int GetOcc(Tree tr, int n){
+    assert(tr != NULL);
+    return tr->blocks[tr->nodes[n].block].weight;
 }
 
 
-void ResetToInternalNode(TreeNode trn){
-    assert(trn != NULL);
-    assert(! IsInternalNode(trn));
-    trn->c = INTERNAL_NODE_C;
-    return;
-}
+int NodeCode(Tree tr, int n, uint64_t* code, int* top){
+    assert(tr != NULL && code != NULL && top != NULL);
 
+    // right child at an odd position = 1, left = 0
+    uint64_t result = 0;
+    int len = 0;
+    int t = GetPosition(tr, n);
 
-void UpdateNYT(Tree tr, TreeNode NYT){
-    assert(tr != NULL && NYT != NULL);
-    assert(IsNYTNode(NYT));
-    
-    tr->NYT = NYT;
-    return;
+    while (t != 0 && len < 64){
+        result |= (uint64_t) (t & 1) << len;
+        len++;
+        n = tr->parent_at[t];
+        t = GetPosition(tr, n);
+    }
+
+    *code = result;
+    *top = t;
+    return len;
 }
 
 
@@ -219,36 +220,54 @@ void TreeShow(Tree tr){
     assert(tr != NULL);
 
     printf("Tree: ");
-    TreeShowFunction(tr->root);
+    if (tr->node_num > 0){
+        TreeShowFunction(tr, tr->root);
+    }
+    printf("\n");
+
+    // the blocks from the root down
+    printf("Blocks: ");
+    int t = 0;
+    while (t < tr->node_num){
+        struct _Block* bk = &tr->blocks[tr->block_at[t]];
+        printf("(%s, %d, x%d) ", IsLeafNode(tr, bk->leader) ? "Leaf" : "Internal", bk->weight, bk->size);
+        t += bk->size;
+    }
     printf("\n");
     return;
 }
 
 
-void TreeShowFunction(TreeNode trn){
-    if (trn != NULL){
+void TreeShowFunction(Tree tr, int n){
+    if (! IsLeafNode(tr, n)){
         // in-order traversal
         // show left first
-        TreeShowFunction(trn->left);
-
-        // show myself
-        if (trn->c >= 0){
-            printf("(%c-%d, %d) ", trn->c, trn->c, trn->occ);
-        }
-        else if (trn->c == ROOT_C){
-            printf("(Root, %d) ", trn->occ);
-        }
-        else if (trn->c == NYT_C){
-            printf("(NYT, %d) ", trn->occ);
-        }
-        else{
-            // internal node
-            printf("(Internal, %d) ", trn->occ);
-        }
+        TreeShowFunction(tr, GetChild(tr, n, 0));
+    }
 
+    // show myself
+    int c = tr->nodes[n].c;
+    if (c >= 0 && tr->alphabet > ASCII_SIZE){
+        printf("(%d, %d) ", c, GetOcc(tr, n));
+    }
+    else if (c >= 0){
+        printf("(%c-%d, %d) ", c, c, GetOcc(tr, n));
+    }
+    else if (c == ROOT_C){
+        printf("(Root, %d) ", GetOcc(tr, n));
+    }
+    else if (c == NYT_C){
+        printf("(NYT, %d) ", GetOcc(tr, n));
+    }
+    else{
+        // internal node
+        printf("(Internal, %d) ", GetOcc(tr, n));
+    }
+
+    if (! IsLeafNode(tr, n)){
         // show right
-        TreeShowFunction(trn->right);
+        TreeShowFunction(tr, GetChild(tr, n, 1));
     }
 
     return;
-}
\ No newline at end of file
+}
@@ -1,10 +1,12 @@
-/* 
+/*
 * This file follows the dynamic huffman vitter algorithm
-* Follows the paper (Vitter, 1987), "Design and Analysis of Dynamic Huffman Codes"
-* The implementation follows the pesudo code, 
-* not his paper about the Pascal implementation (Vitter, 1989).
-* So the execution time will be a bit longer than the optimized program in his second paper.
-* Reference: 
+* Follows the paper (Vitter, 1987), "Design and Analysis of Dynamic Huffman Codes".
+* The arrays are in the style of his second paper (Vitter, 1989), Algorithm 673:
+* the implicit numbering is kept in arrays, and the nodes of the same weight
+* and type are grouped into blocks, so no list is walked during the update.
+* It is not a transcription of 673: the leaves and the internal nodes are
+* numbered in two ranges, and the rescale builds the tree again from the occ.
+* Reference:
 * Vitter, J., 1989. Algorithm 673. ACM Transactions on Mathematical Software (TOMS), 15(2), pp.158-167.
 * Vitter, J., 1987. Design and analysis of dynamic Huffman codes. Journal of the ACM (JACM), 34(4), pp.825-845.
 */
@@ -17,6 +19,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 
 // so the leaf node has char c >= 0
@@ -26,29 +29,98 @@
 #define NYT_C -3
 
 
-// ASCII table size = 256
+// the alphabet: the symbols are 0 to alphabet - 1, bytes by default.
+// any size up to 2^16 works, like 16 bits symbols or the tokens of a LZ pass
 #define ASCII_SIZE 256
-
-
-// tree node
-// due to implicit numbering, we do not need to use "label" as in the FGK algorithm
-struct _TreeNode{
-    int c;
-    int occ;
-    struct _TreeNode *left;
-    struct _TreeNode *right;
-    struct _TreeNode *parent;
+#define ALPHABET_MAX (1 << 16)
+
+// no node / no block
+#define NO_NODE -1
+
+
+// rescale: when the root occ reaches 1 << bits, the occ of every leaf is
+// halved and the tree is built again, so the occ never overflows and old
+// statistics fade out. the default keeps files below 1 GB as they were.
+// the limit must be above the alphabet, since every leaf keeps occ 1 at least
+#define RESCALE_DEFAULT_BITS 30
+#define RESCALE_MIN_BITS 9
+#define RESCALE_MAX_BITS 30
+
+
+// the implicit numbering is kept as positions, from the root (0) down to
+// the NYT (node_num - 1). the two children of a node are always next to each
+// other: the right child at an odd position t, the left child at t + 1.
+//
+// floating tree: the parent belongs to the pair of positions, and the
+// children to the internal node. so when the nodes slide to other positions,
+// the children go with their parent, and nothing else needs to change.
+//
+// block: the nodes of the same weight and the same type (leaf or internal)
+// are next to each other in the implicit numbering, and their numbers are
+// consecutive. so the block keeps the node of each position: the leader has
+// the max number and the top (min) position, the others follow one by one.
+// the root is always a block of its own.
+struct _Block{
+    int weight;
+    int leader;             // node number of the leader
+    int size;
+    int top;                // position of the leader
 };
 
 
-// define the pointer
-typedef struct _TreeNode *TreeNode;
+// tree node, indexed by the node number
+struct _Node{
+    int c;                  // the char of a leaf, NYT_C, INTERNAL_NODE_C or ROOT_C
+    int child;              // position of the right child, NO_NODE for a leaf
+    int block;
+};
 
 
 // define the tree
+// for an alphabet of size A, the leaves are A symbols and the NYT, the internal
+// nodes are A - 1 and the root. all the arrays are sized by the alphabet.
+//
+// node numbers: leaves are 0 to leaf_number - 1, internal nodes are the rest.
+// in each range the number grows with the implicit numbering, and the
+// new nodes take the lowest numbers, so the root is always the last node
 struct _Tree{
-    TreeNode root;
-    TreeNode NYT;
+    int alphabet;
+    int symbol_bits;            // bits of a new symbol after the NYT code
+    int leaf_number;            // A + 1
+    int node_number;            // 2A + 1
+    int root;                   // node_number - 1
+
+    struct _Node* nodes;
+    int node_num;               // positions used, 0 before the first char
+    int NYT;                    // node number of the NYT
+
+    // lowest node numbers used, a new leaf / internal node takes the one below
+    int leaf_low;
+    int internal_low;
+
+    // leaf of each symbol, NO_NODE if not seen yet
+    int* rep;
+
+    // for each position: its block, and the parent of the pair it belongs to
+    int* block_at;
+    int* parent_at;
+
+    // blocks and a stack of the unused ones
+    struct _Block* blocks;
+    int* free_blocks;
+    int free_block_num;
+
+    int rescale_limit;          // root occ that triggers a rescale
+
+    // scratch of TreeRebuild and of its callers, allocated once.
+    // keys: one per leaf, queue: one per internal node, the rest per position
+    long* keys;
+    int* pos_c;
+    int* pos_occ;
+    int* pos_child;
+    int* node_at;
+    int* queue_occ;
+    int* queue_child;
 };
 
 
@@ -56,60 +128,49 @@ struct _Tree{
 typedef struct _Tree *Tree;
 
 
-// create and destroy the treenode
-TreeNode TreeNodeCreate(int c, int occ, TreeNode left, TreeNode right, TreeNode parent);
-TreeNode TreeNodeDestroy(TreeNode);
-
-
-// create and destroy the tree
-Tree TreeCreate(void);
+// create and destroy the tree, for symbols 0 to alphabet - 1
+Tree TreeCreate(int alphabet);
 Tree TreeDestroy(Tree);
 
+// rescale when the root occ reaches 1 << bits, bits > symbol_bits
+void TreeSetRescale(Tree, int bits);
 
-// some check functions for the tree
-bool IsRightChild(TreeNode child, TreeNode parent);
-bool IsRootNode(TreeNode trn);
-bool IsInternalNode(TreeNode trn);
-bool IsLeafNode(TreeNode trn);
-bool IsNYTNode(TreeNode trn);
-bool IsSymbolNode(TreeNode trn);
-bool IsNYTSubling(TreeNode trn);
 
+// take a free block and give it back
+int BlockCreate(Tree tr, int weight, int leader, int size, int top);
+void BlockDestroy(Tree tr, int b);
 
-// increase occ by 1 for the treenode
-void IncreaseOcc(TreeNode trn);
 
+// some check functions for the node number
+bool IsLeafNode(Tree tr, int n);
+bool IsRootNode(Tree tr, int n);
+bool IsNYTNode(Tree tr, int n);
+bool IsNYTSibling(Tree tr, int n);
+bool IsRootBlock(Tree tr, int b);
 
-// construct the tree: connect to parent, right, left,
-// or input the right/left boolean variable and connect
-void ConnectAsParent(TreeNode child, TreeNode parent);
-void ConnectAsRightChild(TreeNode child, TreeNode parent);
-void ConnectAsLeftChild(TreeNode child, TreeNode parent);
-void ConnectAsChild(TreeNode child, TreeNode parent, bool isRightChild);
 
+// position of node n, and the node at position t
+int GetPosition(Tree tr, int n);
+int GetNodeAt(Tree tr, int t);
 
-// Get the root node or NYT node
-TreeNode GetRoot(Tree tr);
-TreeNode GetNYT(Tree tr);
+// parent node of n, NO_NODE for the root
+int GetParent(Tree tr, int n);
 
+// child of an internal node: 1 = right, 0 = left
+int GetChild(Tree tr, int n, int bit);
 
-// Get the information from the treenode
-int GetC(TreeNode trn);
-int GetOcc(TreeNode trn);
-TreeNode GetRight(TreeNode trn);
-TreeNode GetLeft(TreeNode trn);
-TreeNode GetParent(TreeNode trn);
+// weight of node n, the weight of its block
+int GetOcc(Tree tr, int n);
 
 
-// when a new symbol is introduced,
-// reset the previous NYT node to internal node,
-// and reset the NYT pointer of the tree
-void ResetToInternalNode(TreeNode trn);
-void UpdateNYT(Tree tr, TreeNode NYT);
+// the code of node n, collected in one walk up to the root: the bit of the
+// root is the highest one, the bit of n the lowest.
+// return the code length, or stop at 64 bits and give the node reached in *top
+int NodeCode(Tree tr, int n, uint64_t* code, int* top);
 
 
-// debug use: in-order traversal of the tree
+// debug use: in-order traversal of the tree, and the blocks
 void TreeShow(Tree);
 
 
-#endif 
\ No newline at end of file
+#endif
@@ -3,406 +3,394 @@
 #include <assert.h>
 #include <stdbool.h>
 #include "tree.h"
-#include "list.h"
-#include "dictionary.h"
-#include "file.h"
 #include "update.h"
 
 
-// additional function for the slide and increment: 
-// find the block to slide
-// boundary: from LN_start and does not include LN_final
-void FindSlideBoundary(ListNode LN, ListNode* LN_start_p, ListNode* LN_final_p);
-
-
-// additional function for swap with leader.
-// find the leader of the block, may return NULL
-ListNode FindLeaderInTheBlock(ListNode);
-
-
 void TreeUpdateForFirstChar(Tree tr, int c){
-    assert(tr != NULL);
-    assert(c >= 0);
-    
+    assert(tr != NULL && tr->node_num == 0);
+    assert(c >= 0 && c < tr->alphabet);
+
     // this is the first char
     // split the root into NYT on the left and new node on the right
-    // the tree is created already
-
-    // first create a TreeNode for the new char
     // so here the new symbol node is assigned with occ = 1 directly
-    TreeNode newNode = TreeNodeCreate(c, 1, NULL, NULL, GetRoot(tr));
-    TreeNode newNYT = TreeNodeCreate(NYT_C, 0, NULL, NULL, GetRoot(tr));
-
-    ConnectAsLeftChild(newNYT, GetRoot(tr));
-    ConnectAsRightChild(newNode, GetRoot(tr));
-
-    IncreaseOcc(GetRoot(tr));
-
-    UpdateNYT(tr, newNYT);
+    int root = tr->root;
+    int leaf = tr->leaf_number - 1;
+    int NYT = leaf - 1;
+
+    tr->nodes[root].c = ROOT_C;
+    tr->nodes[root].child = 1;
+    tr->nodes[leaf].c = c;
+    tr->nodes[leaf].child = NO_NODE;
+    tr->nodes[NYT].c = NYT_C;
+    tr->nodes[NYT].child = NO_NODE;
+
+    // root at 0, the new char at 1 and the NYT at 2, each in its own block
+    tr->nodes[root].block = BlockCreate(tr, 1, root, 1, 0);
+    tr->nodes[leaf].block = BlockCreate(tr, 1, leaf, 1, 1);
+    tr->nodes[NYT].block = BlockCreate(tr, 0, NYT, 1, 2);
+
+    tr->block_at[0] = tr->nodes[root].block;
+    tr->block_at[1] = tr->nodes[leaf].block;
+    tr->block_at[2] = tr->nodes[NYT].block;
+    tr->parent_at[0] = NO_NODE;
+    tr->parent_at[1] = root;
+    tr->parent_at[2] = root;
+
+    tr->rep[c] = leaf;
+    tr->NYT = NYT;
+    tr->leaf_low = NYT;
+    tr->internal_low = root;
+    tr->node_num = 3;
 
     return;
 }
 
 
-ListNode ListUpdateForFirstChar(List L, Tree tr){
-    assert(L != NULL);
+void UpdateTree(Tree tr, int c){
     assert(tr != NULL);
-    // check root node
-    assert(GetRoot(tr) != NULL);
-    // check it has a left NYT and right child not null
-    assert(GetRight(GetRoot(tr)) != NULL && GetLeft(GetRoot(tr)) == GetNYT(tr));
-    // check the left child of root is a NYT node
-    assert(IsNYTNode(GetLeft(GetRoot(tr))));
-    // check the right child is a symbol node
-    assert(IsSymbolNode(GetRight(GetRoot(tr))));
-
-
-    // create list node for: NYT, right child, and root
-    // then link them together
-    ListNode LN_NYT = ListNodeCreate(GetNYT(tr));
-    ListNode LN_right = ListNodeCreate(GetRight(GetRoot(tr)));
-    ListNode LN_root = ListNodeCreate(GetRoot(tr));
-
-    // assign the list node
-    // L->next = LN_NYT;
-    AssignListHead(L, LN_NYT);
-
-    // forward link
-    ConnectAsNext(LN_NYT, LN_right);
-    ConnectAsNext(LN_right, LN_root);
-
-    // backward link
-    ConnectAsPrev(LN_root, LN_right);
-    ConnectAsPrev(LN_right, LN_NYT);
-
-    return LN_right;
-}
+    assert(c >= 0 && c < tr->alphabet);
 
+    if (tr->node_num == 0){
+        TreeUpdateForFirstChar(tr, c);
+        return;
+    }
 
-void UpdateTreeAndList(Tree tr, List L, Dictionary d, ListNode LN_p, int c){
-    assert(tr != NULL);
-    assert(L != NULL);
-    assert(d != NULL);
-    assert(LN_p != NULL);
-    assert(c >= 0);
-
-    // now the list node LN_c is either listnode NYT, or the listnode for the symbol
-
-    ListNode LN_LeafToIncrement = NULL;
-    TreeNode trn_p = GetTreeNode(LN_p);
-
-    if (IsNYTNode(trn_p)){
-        // change the current trn NYT to internal trn
-        ResetToInternalNode(trn_p);
-
-        // create two new trn: NYT and the new symbol
-        TreeNode trn_NYT = TreeNodeCreate(NYT_C, 0, NULL, NULL, NULL);
-        // update the NYT in the tree
-        UpdateNYT(tr, trn_NYT);
-
-        // create a node for this new symbol
-        TreeNode trn_c = TreeNodeCreate(c, 0, NULL, NULL, NULL);
-
-        // reconstruct that tree
-        // top to down
-        ConnectAsLeftChild(trn_NYT, trn_p);
-        ConnectAsRightChild(trn_c, trn_p);
-        // bottom to up
-        ConnectAsParent(trn_NYT, trn_p);
-        ConnectAsParent(trn_c, trn_p);
-
-        // add to list
-        ListNode LN_internal = LN_p;        // the NYT list node
-        
-        // create list node for the new NYT and new symbol node
-        ListNode LN_NYT = ListNodeCreate(trn_NYT);
-
-        // new symbol node
-        ListNode LN_c = ListNodeCreate(trn_c);
-        // for the new symbol, insert into dictionary
-        DictionaryInsert(d, LN_c);
-        
-        // reconstruct the list, left to right
-        AssignListHead(L, LN_NYT);
-        ConnectAsNext(LN_NYT, LN_c);
-        ConnectAsNext(LN_c, LN_internal);
-
-        // right to left
-        ConnectAsPrev(LN_internal, LN_c);
-        ConnectAsPrev(LN_c, LN_NYT);
-
-        // p = parent of the symbol node, LN_p does not change
-        // leaf to increment = the right child of trn_p
-        LN_LeafToIncrement = LN_c;        
+    int p = tr->rep[c];
+    int leaf_to_increment = NO_NODE;
+
+    if (p == NO_NODE){
+        // the NYT becomes an internal node, with the new NYT on the left
+        // and the new symbol on the right, both of weight 0
+        int t = tr->node_num - 1;
+        int old_NYT = tr->NYT;
+        int b = tr->nodes[old_NYT].block;
+        assert(tr->blocks[b].size == 1 && tr->blocks[b].weight == 0);
+
+        // the new symbol takes the number of the old NYT, just above the new NYT
+        int leaf = old_NYT;
+        int NYT = old_NYT - 1;
+        int internal = tr->internal_low - 1;
+
+        tr->nodes[internal].c = INTERNAL_NODE_C;
+        tr->nodes[internal].child = t + 1;
+        tr->nodes[leaf].c = c;
+        tr->nodes[leaf].child = NO_NODE;
+        tr->nodes[NYT].c = NYT_C;
+        tr->nodes[NYT].child = NO_NODE;
+
+        // the leaves of weight 0 reuse the block of the old NYT
+        tr->blocks[b].leader = leaf;
+        tr->blocks[b].size = 2;
+        tr->blocks[b].top = t + 1;
+        tr->nodes[NYT].block = b;
+        tr->nodes[internal].block = BlockCreate(tr, 0, internal, 1, t);
+
+        tr->block_at[t] = tr->nodes[internal].block;
+        tr->block_at[t+1] = b;
+        tr->block_at[t+2] = b;
+        tr->parent_at[t+1] = internal;
+        tr->parent_at[t+2] = internal;
+
+        tr->rep[c] = leaf;
+        tr->NYT = NYT;
+        tr->leaf_low = NYT;
+        tr->internal_low = internal;
+        tr->node_num += 2;
+
+        // p = parent of the symbol node
+        // leaf to increment = the right child of p
+        p = internal;
+        leaf_to_increment = leaf;
     }
     else{
-        // swap trn_p in the tree with the leader of its block
-        SwapWithLeader(L, LN_p);
+        // swap p in the tree with the leader of its block
+        p = SwapWithLeader(tr, p);
 
         // if p is the sibling of the 0 node
-        if (IsNYTSubling(trn_p)){
-            // leaf to increment = p, but assign with its outer structure list node
-            LN_LeafToIncrement = LN_p;
-
-            // p = parent of p, need to find the list node
-            LN_p = FindParentListNode(LN_p);
+        if (IsNYTSibling(tr, p)){
+            leaf_to_increment = p;
+            p = GetParent(tr, p);
         }
     }
 
-    // debug
-    // printf("before slide&incre:\n");
-    // TreeShow(tr);
-    // ListShow(L);
-
     // while p is not the root of the tree
-    while (! IsRootNode(GetTreeNode(LN_p))){
-        SlideAndIncrement(L, &LN_p);
+    while (! IsRootNode(tr, p)){
+        SlideAndIncrement(tr, &p);
     }
 
-    // increase root weight
-    IncreaseOcc(GetTreeNode(LN_p));
+    // increase root weight, the root is a block of its own
+    tr->blocks[tr->nodes[tr->root].block].weight += 1;
 
-    if (LN_LeafToIncrement != NULL){
-        SlideAndIncrement(L, &LN_LeafToIncrement);
+    if (leaf_to_increment != NO_NODE){
+        SlideAndIncrement(tr, &leaf_to_increment);
     }
 
-    // debug
-    // printf("after slide&incre:\n");
-    // TreeShow(tr);
-    // ListShow(L);
-    // printf("\n");
+    // the encoder and the decoder rescale at the same symbol
+    if (GetOcc(tr, tr->root) >= tr->rescale_limit){
+        Rescale(tr);
+    }
 
     return;
 }
 
 
-void SlideAndIncrement(List L, ListNode* LN_p){
-    // perform some checks, the inside treenode cannot be root or NYT
-    assert(L != NULL);
-    assert(LN_p != NULL && (*LN_p)->trn != NULL);  
-    assert( (! IsRootNode(GetTreeNode(*LN_p))) && (! IsNYTNode(GetTreeNode(*LN_p))) );
-
-
-    // record its original parent tree node
-    TreeNode trn_fp = GetParent(GetTreeNode(*LN_p));
-
-    // find the boundary of the slide
-    ListNode LN_start = NULL;
-    ListNode LN_final = NULL;
-    FindSlideBoundary(*LN_p, &LN_start, &LN_final);
-
-
-    // if nothing to slide, skip to bottom to increase the weight
-    if (LN_start != NULL && LN_final != NULL){
-        ListNode LN_this = LN_start;
-        TreeNode prev_parent = GetParent(GetTreeNode(*LN_p));
-
-        bool prev_is_right_child = IsRightChild(GetTreeNode(*LN_p), prev_parent);
-        bool cur_is_right_child = false;
-
-        TreeNode this_parent;
-
-
-        while (LN_this != LN_final){
-            // check current is right child or not
-            this_parent = LN_this->trn->parent;
-            cur_is_right_child = IsRightChild(GetTreeNode(LN_this), this_parent);
+void SlideAndIncrement(Tree tr, int* p){
+    assert(tr != NULL && p != NULL);
+
+    int n = *p;
+    assert(! IsRootNode(tr, n) && ! IsNYTNode(tr, n));
+
+    // p is always the leader of its block, at the top position of the block
+    int b = tr->nodes[n].block;
+    struct _Block* bk = &tr->blocks[b];
+    assert(bk->leader == n);
+
+    int t = bk->top;
+    int fp = tr->parent_at[t];
+    int weight = bk->weight;
+    bool leaf = IsLeafNode(tr, n);
+
+    // the block just above p: a leaf slides over the internal nodes of the
+    // same weight, an internal node over the leaves of weight + 1.
+    // the block moves one position down, and p takes its top position
+    int t_new = t;
+    int r = tr->block_at[t-1];
+    if (! IsRootBlock(tr, r) && IsLeafNode(tr, tr->blocks[r].leader) != leaf
+        && tr->blocks[r].weight == (leaf ? weight : weight + 1)){
+        t_new = tr->blocks[r].top;
+        tr->blocks[r].top += 1;
+        tr->block_at[t] = r;
+    }
 
-            // connect LN_this->trn as a child of prev_parent
-            // connect from bottom up
-            ConnectAsParent(GetTreeNode(LN_this), prev_parent);
-            // connect from top to bottom
-            ConnectAsChild(GetTreeNode(LN_this), prev_parent, prev_is_right_child);
+    // after the increase, p joins the block above if it has the same type
+    // and weight, at the bottom of that block
+    int a = tr->block_at[t_new - 1];
+    bool join = ! IsRootBlock(tr, a) && IsLeafNode(tr, tr->blocks[a].leader) == leaf
+                && tr->blocks[a].weight == weight + 1;
 
-            // prepare for next list node
-            LN_this = GetNext(LN_this);
-            prev_parent = this_parent;
-            prev_is_right_child = cur_is_right_child;
-            cur_is_right_child = false;
+    int new_block = NO_NODE;
+    if (bk->size == 1){
+        if (join){
+            BlockDestroy(tr, b);
         }
+        else{
+            // p keeps its block
+            bk->weight += 1;
+            bk->top = t_new;
+            new_block = b;
+        }
+    }
+    else{
+        // the next node becomes the leader
+        bk->leader = n - 1;
+        bk->size -= 1;
+        bk->top = t + 1;
 
+        if (! join){
+            new_block = BlockCreate(tr, weight + 1, n, 1, t_new);
+        }
+    }
 
-        // now connect LN_p->trn with the prev_paarent
-        ConnectAsParent(GetTreeNode(*LN_p), prev_parent);
-        ConnectAsChild(GetTreeNode(*LN_p), prev_parent, prev_is_right_child);
-
-
-        // so far, re-link at the tree level is completed
-        // move the LN_p to the position before LN_final
-        ListNode LN_left_most = GetPrev(*LN_p);
-        ListNode LN_right_before_final = GetPrev(LN_final);
-
-        // the original sequence is: LN_left_most, LN_p, LN_start, xx, xx, LN_right_before_final, LN_final
-        // the new sequence is: LN_left_most, LN_start, xx, xx, LN_right_before_final, LN_p, LN_final
-        // forward link
-        ConnectAsNext(LN_left_most, LN_start);
-        ConnectAsNext(LN_right_before_final, *LN_p);
-        ConnectAsNext(*LN_p, LN_final);
-        // backward link
-        ConnectAsPrev(LN_final, *LN_p);
-        ConnectAsPrev(*LN_p, LN_right_before_final);
-        ConnectAsPrev(LN_start, LN_left_most);
+    if (join){
+        assert(tr->blocks[a].leader - tr->blocks[a].size == n);
+        tr->blocks[a].size += 1;
+        new_block = a;
     }
 
+    tr->nodes[n].block = new_block;
+    tr->block_at[t_new] = new_block;
 
-    // increase p weight
-    IncreaseOcc(GetTreeNode(*LN_p));
-    
     // move upwards
     // if p is an internal node, p = original parent of p
     // if p is a leaf node, p = new parent of p
-    if (IsInternalNode(GetTreeNode(*LN_p))){
-        (*LN_p) = GetListNode(L, trn_fp);
+    if (leaf){
+        (*p) = tr->parent_at[t_new];
     }
     else{
-        (*LN_p) = GetListNode(L, GetParent(GetTreeNode(*LN_p)));
+        (*p) = fp;
     }
 
     return;
 }
 
 
-void SwapWithLeader(List L, ListNode LN){
-    // check not null, and the list node must be a leaf node
-    assert(L != NULL);
-    assert(LN != NULL && GetTreeNode(LN) != NULL && IsLeafNode(GetTreeNode(LN)) );
-    
-
-    // find the leader of the block, could be null
-    ListNode LN_leader = FindLeaderInTheBlock(LN);
-
-    // if the leader of the block exist 
-    // (otherwise means the LN is already the leader of the block)
-    if (LN_leader != NULL){
-        // first reconnect at the tree level
-        TreeNode trn_p = GetParent(GetTreeNode(LN));;        
-        bool trn_is_right_child = IsRightChild(GetTreeNode(LN), trn_p);
-
-        TreeNode trn_leader_p = GetParent(GetTreeNode(LN_leader));
-        bool trn_leader_p_is_right_child = IsRightChild(GetTreeNode(LN_leader), trn_leader_p);
-
-        // after get all information, reconnect at the tree level
-        
-        // bottom up
-        ConnectAsParent(GetTreeNode(LN), trn_leader_p);
-        ConnectAsParent(GetTreeNode(LN_leader), trn_p);
-
-        // top to bottom
-        ConnectAsChild(GetTreeNode(LN_leader), trn_p, trn_is_right_child);
-        ConnectAsChild(GetTreeNode(LN), trn_leader_p, trn_leader_p_is_right_child);
-
-
-        // then reconnect at the list level
-        // take caution when LN and LN_leader are next to each other
-        if (LN->next == LN_leader){
-            // if next to each other
-            ListNode left = GetPrev(LN);
-            ListNode right = GetNext(LN_leader);
-
-            // the new order is: left, LN_leader, LN, right
-            // forward
-            ConnectAsNext(left, LN_leader);
-            ConnectAsNext(LN_leader, LN);
-            ConnectAsNext(LN, right);
-            // backward
-            ConnectAsPrev(right, LN);
-            ConnectAsPrev(LN, LN_leader);
-            ConnectAsPrev(LN_leader, left);
-        }
-        else{
-            // if they are not next to each other
-            // old order: left, LN, mid1, ..., mid2, LN_leader, right
-            ListNode left = GetPrev(LN);
-            ListNode mid1 = GetNext(LN);
-            ListNode mid2 = GetPrev(LN_leader);
-            ListNode right = GetNext(LN_leader);
-
-            // new order: left, LN_leader, mid1, ...., mid2, LN, right
-            // forward 
-            ConnectAsNext(left, LN_leader);
-            ConnectAsNext(LN_leader, mid1);
-            ConnectAsNext(mid2, LN);
-            ConnectAsNext(LN, right);
-            // backwaard
-            ConnectAsPrev(right, LN);
-            ConnectAsPrev(LN, mid2);
-            ConnectAsPrev(mid1, LN_leader);
-            ConnectAsPrev(LN_leader, left);
+int SwapWithLeader(Tree tr, int n){
+    assert(tr != NULL);
+    assert(IsLeafNode(tr, n) && tr->nodes[n].c >= 0);
+
+    int leader = tr->blocks[tr->nodes[n].block].leader;
+
+    // the leaves exchange their chars, the positions stay
+    if (leader != n){
+        int c = tr->nodes[n].c;
+        int c_leader = tr->nodes[leader].c;
+
+        tr->nodes[n].c = c_leader;
+        tr->nodes[leader].c = c;
+        tr->rep[c_leader] = n;
+        tr->rep[c] = leader;
+    }
+
+    return leader;
+}
+
+
+// halve the occ of every leaf, and build the tree from them
+void Rescale(Tree tr){
+    assert(tr != NULL);
+
+    // the tree keeps its nodes, so all the work is in the nodes used, not
+    // in the whole alphabet, which can be large and rescaled often
+    int leaf_num = (tr->node_num - 1) / 2;
+    long* keys = tr->keys;
+
+    // the leaves: occ in the high bits and the symbol in the low bits
+    int k = 0;
+    for (int t = 0; t < tr->node_num; t++){
+        int n = GetNodeAt(tr, t);
+        if (tr->nodes[n].c >= 0){
+            long occ = (GetOcc(tr, n) + 1) / 2;
+            keys[k++] = (occ << tr->symbol_bits) | tr->nodes[n].c;
         }
     }
+    assert(k == leaf_num);
+    qsort(keys, leaf_num, sizeof(long), CompareLong);
 
+    TreeRebuild(tr, keys, leaf_num);
     return;
 }
 
 
-// range of slide: [start, final), note the right endpoint is not included
-void FindSlideBoundary(ListNode LN, ListNode* LN_start_p, ListNode* LN_final_p){
-    // check all pointers
-    assert(LN != NULL && LN_start_p != NULL && LN_final_p != NULL);
-    // also, the trn must be either a symbol node or an internal node
-    assert( IsSymbolNode(GetTreeNode(LN)) || IsInternalNode(GetTreeNode(LN)) );
+// build the tree again the same way as the static huffman tree, but with
+// two queues: the leaves sorted by occ, and the new internal nodes, which
+// come out in increasing occ by themselves. the order of taking out is
+// the implicit numbering from the bottom, and the two nodes taken together
+// are siblings.
+// on the same occ the leaf is taken first, so that leaves precede the
+// internal nodes of the same occ. the NYT (occ 0) is the first one.
+void TreeRebuild(Tree tr, long* keys, int leaf_num){
+    assert(tr != NULL && keys != NULL && leaf_num >= 1);
+
+    int bits = tr->symbol_bits;
+    long mask = (1L << bits) - 1;
+
+    // the old blocks are free again
+    for (int t = 0; t < tr->node_num; ){
+        int b = tr->block_at[t];
+        t += tr->blocks[b].size;
+        BlockDestroy(tr, b);
+    }
+
+    int total = 2 * leaf_num + 1;
+    assert(total <= tr->node_number);
 
-    int target_occ;
-    ListNode cur;
+    int* pos_c = tr->pos_c;
+    int* pos_occ = tr->pos_occ;
+    int* pos_child = tr->pos_child;
+    int* node_at = tr->node_at;
+    int* queue_occ = tr->queue_occ;
+    int* queue_child = tr->queue_child;
 
-    if (IsLeafNode(GetTreeNode(LN))){
-        // for a leaf node, find the same weight internal node range
-        target_occ = GetOcc(GetTreeNode(LN));
+    // each position: symbol, weight and the right child of an internal node
 
-        if (GetNext(LN) != NULL && IsInternalNode(GetTreeNode(GetNext(LN))) && GetOcc(GetTreeNode(GetNext(LN))) == target_occ){
-            // find the start
-            (*LN_start_p) = GetNext(LN);
+    // internal nodes queue
+    int queue_head = 0;
+    int queue_tail = 0;
 
-            cur = GetNext(GetNext(LN));
-            
-            while (cur != NULL && IsInternalNode(GetTreeNode(cur)) && GetOcc(GetTreeNode(cur)) == target_occ){
-                cur = GetNext(cur);
-            }
+    int next_leaf = -1;             // -1 = the NYT
 
-            // find the final
-            (*LN_final_p) = cur;
+    for (int i = 0; i < total; i++){
+        int t = total - 1 - i;
+
+        if (next_leaf < leaf_num && (queue_head == queue_tail
+            || (next_leaf == -1 ? 0 : keys[next_leaf] >> bits) <= queue_occ[queue_head])){
+            // take a leaf
+            pos_c[t] = (next_leaf == -1) ? NYT_C : (int) (keys[next_leaf] & mask);
+            pos_occ[t] = (next_leaf == -1) ? 0 : (int) (keys[next_leaf] >> bits);
+            pos_child[t] = NO_NODE;
+            next_leaf++;
+        }
+        else{
+            // take an internal node
+            pos_c[t] = INTERNAL_NODE_C;
+            pos_occ[t] = queue_occ[queue_head];
+            pos_child[t] = queue_child[queue_head];
+            queue_head++;
+        }
+
+        // every two nodes make a new internal node, the first one is the left child
+        if (i % 2 == 1){
+            queue_occ[queue_tail] = pos_occ[t] + pos_occ[t+1];
+            queue_child[queue_tail] = t;
+            queue_tail++;
         }
     }
-    else{
-        // internal node: find range of leaf nodes with occ = target_occ + 1
-        target_occ = GetOcc(GetTreeNode(LN)) + 1;
 
-        if (LN->next != NULL && IsSymbolNode(GetTreeNode(GetNext(LN))) && GetOcc(GetTreeNode(GetNext(LN))) == target_occ){
-            (*LN_start_p) = GetNext(LN);
+    // the last one is the root
+    pos_c[0] = ROOT_C;
+
+    // number the nodes from the root down, in each type
+    int next_leaf_number = tr->leaf_number - 1;
+    int next_internal_number = tr->root;
 
-            cur = GetNext(GetNext(LN));   
-              
-            while (cur != NULL && IsSymbolNode(GetTreeNode(cur)) && GetOcc(GetTreeNode(cur)) == target_occ){
-                cur = GetNext(cur);
-            }
+    for (int t = 0; t < total; t++){
+        int n = (pos_child[t] == NO_NODE) ? next_leaf_number-- : next_internal_number--;
+        node_at[t] = n;
 
-            (*LN_final_p) = cur;
+        tr->nodes[n].c = pos_c[t];
+        tr->nodes[n].child = pos_child[t];
+
+        if (pos_c[t] >= 0){
+            tr->rep[pos_c[t]] = n;
+        }
+        else if (pos_c[t] == NYT_C){
+            tr->NYT = n;
         }
     }
 
-    return;
-}
+    tr->leaf_low = next_leaf_number + 1;
+    tr->internal_low = next_internal_number + 1;
+    tr->node_num = total;
 
+    tr->parent_at[0] = NO_NODE;
+    for (int t = 0; t < total; t++){
+        if (pos_child[t] != NO_NODE){
+            tr->parent_at[pos_child[t]] = node_at[t];
+            tr->parent_at[pos_child[t] + 1] = node_at[t];
+        }
+    }
 
-// only look for leader of a leaf node
-ListNode FindLeaderInTheBlock(ListNode LN){
-    assert(LN != NULL && GetTreeNode(LN) != NULL && IsLeafNode(GetTreeNode(LN)));
+    // the blocks again: runs of the same type and weight, the root alone
+    int t = 0;
+    while (t < total){
+        int size = 1;
+        while (t != 0 && t + size < total && pos_occ[t + size] == pos_occ[t]
+               && (pos_child[t + size] == NO_NODE) == (pos_child[t] == NO_NODE)){
+            size++;
+        }
 
-    int occ = GetOcc(GetTreeNode(LN));
-    ListNode result = GetNext(LN);
+        int b = BlockCreate(tr, pos_occ[t], node_at[t], size, t);
+        for (int i = t; i < t + size; i++){
+            tr->nodes[node_at[i]].block = b;
+            tr->block_at[i] = b;
+        }
 
-    while (result != NULL && IsLeafNode(GetTreeNode(result)) && GetOcc(GetTreeNode(result)) == occ){
-        result = GetNext(result);
+        t += size;
     }
 
-    // move one step back
-    result = GetPrev(result);
+    return;
+}
+
+
+int CompareLong(const void* a, const void* b){
+    long x = *(const long*) a;
+    long y = *(const long*) b;
 
-    // if valid, return
-    if (IsLeafNode(GetTreeNode(result)) && GetOcc(GetTreeNode(result)) == occ){
-        return result;
+    if (x < y){
+        return -1;
     }
-    else{
-        return NULL;
+    else if (x > y){
+        return 1;
     }
-}
\ No newline at end of file
+    return 0;
+}
@@ -1,12 +1,13 @@
 /*
 * Update functions.
-* Follow Vitter's paper to finalize the update function. 
+* Follow Vitter's paper to finalize the update function.
 * So when a symbol is extracted from the input file, either occ count increase by 1,
 * or the NYT symbol is splitted into two symbols.
-* For each procedure, update and balance the tree from bottom up. 
-* Main process is done through SlideAndIncrement, 
-* where both the list and the tree are reconstructed to maintain the balance of the tree,
+* For each procedure, update and balance the tree from bottom up.
+* Main process is done through SlideAndIncrement,
+* where the blocks are moved to keep the balance of the tree,
 * and the "leaf nodes precede internal nodes" statement in Vitter's paper.
+* Every step only changes a few blocks, so the update takes O(depth).
 */
 
 
@@ -17,26 +18,39 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "tree.h"
-#include "list.h"
-#include "dictionary.h"
 
 
-// Update the tree and the list after reading the first char
+// Update the tree after reading the first char
 void TreeUpdateForFirstChar(Tree tr, int c);
-ListNode ListUpdateForFirstChar(List L, Tree tr);
 
 
-// top function for update
-void UpdateTreeAndList(Tree tr, List L, Dictionary d, ListNode LN_p, int c);
+// top function for update, c can be new or existing
+void UpdateTree(Tree tr, int c);
 
 
-// slide the block of internal nodes / leaf nodes, and increase count from bottom up
-void SlideAndIncrement(List, ListNode*);
+// slide p over the next block of the other type if it should,
+// and increase its weight, then move p upwards
+void SlideAndIncrement(Tree tr, int* p);
 
 
-// when an existing symbol is input again, swap its node with the leader of the block,
-// then do the slide and increment. 
-void SwapWithLeader(List, ListNode);
+// when an existing symbol is input again, swap its leaf with the leader of the block,
+// and return the leader, which now holds the symbol
+int SwapWithLeader(Tree tr, int n);
 
 
-#endif 
\ No newline at end of file
+// halve the occ of every leaf (at least 1), and build the tree again
+// called by UpdateTree when the root occ reaches the limit of the tree
+void Rescale(Tree tr);
+
+
+// build the tree from the leaves in keys, (occ << symbol_bits) | symbol,
+// sorted, and the NYT. the symbols of the old tree must all be in keys.
+// keys is usually tr->keys, the other scratch arrays of the tree are used
+void TreeRebuild(Tree tr, long* keys, int leaf_num);
+
+
+// qsort compare of two long
+int CompareLong(const void* a, const void* b);
+
+
+#endif
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
 #include "file.h"
 #include "data_structure.h"
 #include "util.h"
@@ -17,106 +18,157 @@ Create the codeword during the reading.
 
 int main(int argc, char** argv){
     
-    // input check
-    if (argc != 2){
-        fprintf(stderr, "Usage: %s <filename>\n", argv[0]);
+    // input check, optional number of threads, optional segment index,
+    // the policy when the dictionary is full, optional huffman coding,
+    // how the dictionary grows, the seed dictionary it starts with, 
+    // and the output name
+    int threads = 1;
+    bool with_index = false;
+    char* filename_out = NULL;
+    Header h = header_create();
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:ip:Hg:D:o:")) != -1){
+        if (opt == 'j'){
+            threads = atoi(optarg);
+        }
+        else if (opt == 'o'){
+            filename_out = optarg;
+        }
+        else if (opt == 'i'){
+            with_index = true;
+        }
+        else if (opt == 'p' && strcmp(optarg, "full") == 0){
+            h->policy = RESET_FULL;
+        }
+        else if (opt == 'p' && strcmp(optarg, "ratio") == 0){
+            h->policy = RESET_RATIO;
+        }
+        else if (opt == 'p' && strcmp(optarg, "lru") == 0){
+            h->policy = RESET_LRU;
+        }
+        else if (opt == 'H'){
+            h->coder = CODER_HUFFMAN;
+        }
+        else if (opt == 'g' && strcmp(optarg, "lzw") == 0){
+            h->growth = GROWTH_LZW;
+        }
+        else if (opt == 'g' && strcmp(optarg, "lzmw") == 0){
+            h->growth = GROWTH_LZMW;
+        }
+        else if (opt == 'g' && strcmp(optarg, "lzap") == 0){
+            h->growth = GROWTH_LZAP;
+        }
+        else if (opt == 'D' && h->seed == NULL){
+            h->seed = seed_read(optarg);
+            h->dict_id = h->seed->id;
+        }
+        else{
+            threads = 0;
+        }
+    }
+
+    // lru only replaces a single leaf, a whole phrase can not be added that way
+    if (h->growth != GROWTH_LZW && h->policy == RESET_LRU){
+        threads = 0;
+    }
+
+    if (optind != argc - 1 || threads < 1){
+        fprintf(stderr, "Usage: %s [-j threads] [-i] [-p full|ratio|lru] [-H] [-g lzw|lzmw|lzap] [-D seed] [-o output] <filename | ->\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
     // get both file names and open
-    char* filename = argv[1];
-    char* filename_out = create_compressed_file_name(filename);
+    // without -o, add .LZW to the name, or stdin goes to stdout.
+    // nothing seeks, so both can be pipes
+    char* filename = argv[optind];
+    char* name_created = NULL;
+
+    if (filename_out == NULL && strcmp(filename, STREAM_NAME) == 0){
+        filename_out = STREAM_NAME;
+    }
+    else if (filename_out == NULL){
+        name_created = create_compressed_file_name(filename);
+        filename_out = name_created;
+    }
 
     FILE* fp = open_file_for_read(filename);
     FILE* fp_out = open_file_for_write(filename_out);
 
-    // create the dictionary
-    Dictionary d = dictionary_create();
-
-    // create variable for reading
-    char* prev = NULL;
-    char* prev_c = NULL;
-    int c;
-    CodeWord cw;
-    
-    // output use, buffer and the buffer position
-    // position = 8, meaning 8 bits ready, so ok to output
-    int b = 0;
-    int b_position = 0;      
-
-    // after every insert, check if the dictionary is full
-    // if full, output reflush sign and re-initiate
-
-    while ((c=getc(fp)) != EOF){
-        // prev_c = prev + c
-        prev_c = string_concat(prev, c);
-
-        // if dictionary contains prev+c
-        if (dictionary_search(d, prev_c) != -1){
-            // prev = prev + c, assign, first free if necessary
-            if (prev != NULL){
-                free(prev);
-                prev = NULL;
-            }
-
-            // prev = prev_c
-            prev = (char*)malloc((strlen(prev_c)+1)*sizeof(char));
-            assert(prev != NULL);
-            strcpy(prev, prev_c);
-        }    
-        else{
-            // first output code(prev)
-            cw = dictionary_search(d, prev);
-            assert(cw >= 0);
-            print_to_file(fp_out, &b, &b_position, cw);
-
-            // add prev+c to dictionary
-            cw = dictionary_insert(d, prev_c);
-            assert(cw >= 0);
-
-            // prev = c
-            prev = string_concat(NULL, c);
-
-            // when the dictionary is full, need to finish all output first, 
-            // thenprint index for reflush
-            if (dictionary_is_full(d)){
-                // first finish all outputs
-                cw = dictionary_search(d, prev);
-                print_to_file(fp_out, &b, &b_position, cw);
-                
-                // then print index for reflush
-                print_to_file(fp_out, &b, &b_position, INDEX_REFLUSH);
-                
-                // at last, clear all memory and start again
-                d = dictionary_reset(d);
-                prev = NULL;
-                prev_c = NULL;
-                continue;       // go to the start of the loop
-            }
-        }      
-
-        // release the memory
-        free(prev_c);
-        prev_c = NULL;
+    // the first segment starts at the beginning
+    SegmentIndex index = NULL;
+    if (with_index){
+        index = segment_index_create();
     }
 
-    // reach EOF, output the last codeword code(prev)
-    cw = dictionary_search(d, prev);
-    print_to_file(fp_out, &b, &b_position, cw);
+    // output use, the bit writer keeps the bits not yet printed
+    // the header is only printed if the default is not used
+    BitWriter bw = bit_writer_create(fp_out);
+    header_print(bw, h);
 
-    // print the pesudo index eof
-    print_to_file(fp_out, &b, &b_position, INDEX_EOF);
-    final_print_to_file(fp_out, &b, &b_position);
+    // both sizes for the statistics, no need to look at the files again
+    long input_size;
+    long output_size;
+
+    if (threads > 1){
+        // independent segments, one dictionary per thread
+        input_size = compress_parallel(fp, bw, threads, index, h);
+        final_print_to_file(bw);
+
+        if (index != NULL){
+            print_index_to_file(bw, index, input_size);
+        }
+    }
+    else{
+        // the encoder creates the dictionary
+        Encoder e = encoder_create(bw, index, h);
+        if (index != NULL){
+            segment_index_insert(index, bit_writer_tell(bw), 0);
+        }
+
+        // read large blocks, the encoder goes through each block in one call
+        unsigned char* input = io_buffer_create(IO_BUFFER_SIZE);
+        size_t input_len;
+        while ((input_len = fread(input, 1, IO_BUFFER_SIZE, fp)) > 0){
+            encoder_put_bytes(e, input, input_len);
+        }
+        free(input);
+
+        // reach EOF, output the last codeword and the pesudo index eof
+        encoder_finish(e, INDEX_EOF);
+        final_print_to_file(bw);
+
+        if (index != NULL){
+            print_index_to_file(bw, index, e->input_pos);
+        }
+
+        // free the memory
+        input_size = e->input_pos;
+        encoder_destroy(e);
+    }
+
+    // everything is padded to whole bytes by now
+    output_size = bit_writer_tell(bw) / 8;
+    bit_writer_destroy(bw);
+    if (h->seed != NULL){
+        seed_destroy(h->seed);
+    }
+    header_destroy(h);
 
     // close file
     close_file(fp);
     close_file(fp_out);
 
-    // free the memory
-    dictionary_destroy(d);
-
-    // statistics
-    compress_stats(filename, filename_out);
+    // statistics, unless the output itself goes to stdout
+    if (strcmp(filename_out, STREAM_NAME) != 0){
+        compress_stats(filename, filename_out, input_size, output_size);
+    }
+    if (name_created != NULL){
+        free(name_created);
+    }
+    if (index != NULL){
+        segment_index_destroy(index);
+    }
 
     return 0;
 }
@@ -3,12 +3,46 @@
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include "file.h"
 #include "data_structure.h"
 #include "util.h"
 #include "compress_func.h"
 
 
+// one segment of the parallel compression
+struct _Segment{
+    unsigned char* input;
+    long input_len;
+    BitWriter bw;           // in memory output
+    SegmentIndex index;     // reflush points inside the segment, or NULL
+    Header h;
+};
+typedef struct _Segment* Segment;
+
+// thread function, compress one segment
+void* compress_segment(void* arg);
+
+// print the last match and reflush, then start with an empty dictionary
+void encoder_reflush(Encoder e);
+
+// forget the input so far, the dictionary is left as it is
+void encoder_restart(Encoder e);
+
+// RESET_RATIO, reflush if the ratio of the recent input is getting worse
+void encoder_check_ratio(Encoder e);
+
+// after an entry is added, follow the policy if the dictionary is full
+void encoder_check_full(Encoder e);
+
+// the match can not be extended by c, print it and add match + c
+void encoder_add(Encoder e, const int c);
+
+// GROWTH_LZMW and GROWTH_LZAP, walk the pending chars and print the phrases
+void encoder_walk(Encoder e, const bool finish);
+void encoder_print_phrase(Encoder e);
+
+
 // create the compressed file name, add .LZW at the end
 char* create_compressed_file_name(const char* filename){
     assert(filename != NULL);
@@ -24,28 +58,201 @@ char* create_compressed_file_name(const char* filename){
 }
 
 
-// print this byte to the file
-// use pointer so that the remaining bits can be saved and printed later
-void print_to_file(FILE* fp, int* b, int* b_position, const CodeWord cw){
-    // bits position length
-    int cw_position = BITS;
-    int mask;
+// print this codeword to the file
+// the whole BITS bits codeword goes into the bit writer in one go,
+// the remaining bits are kept by the bit writer and printed later
+void print_to_file(BitWriter bw, const CodeWord cw){
+    assert(bw != NULL);
+    bit_writer_put(bw, cw, BITS);
+    return;
+}
+
+
+// pad the remaining bits in the buffer, and print out.
+// if no remaining bits, then only flush the buffer. 
+void final_print_to_file(BitWriter bw){
+    assert(bw != NULL);
+
+    bit_writer_pad(bw);
+    bit_writer_flush(bw);
+
+    return;
+}
+
+
+// create the encoder with an empty dictionary
+Encoder encoder_create(BitWriter bw, SegmentIndex index, const Header h){
+    assert(bw != NULL && h != NULL);
+
+    Encoder e = (Encoder) malloc(sizeof(struct _Encoder));
+    assert(e != NULL);
+
+    e->d = dictionary_create(h->policy, h->growth);
+    dictionary_set_seed(e->d, h->seed);
+    e->bw = bw;
+    e->growth = h->growth;
+    e->pending = NULL;
+    e->index = index;
+    e->policy = h->policy;
+    e->huffman = NULL;
+    encoder_restart(e);
+
+    if (h->coder == CODER_HUFFMAN){
+        e->huffman = huffman_block_create();
+    }
+
+    // a walk is at most as long as the longest entry, + 1 for the char that fails
+    if (h->growth != GROWTH_LZW){
+        e->pending = (unsigned char*) malloc((e->d->node_limit + 1) * sizeof(unsigned char));
+        assert(e->pending != NULL);
+    }
+
+    return e;
+}
+
+
+// everything about the input so far
+void encoder_restart(Encoder e){
+    e->prev = -1;
+    e->last = -1;
+    e->node = -1;
+    e->pending_len = 0;
+    e->walked = 0;
+    e->prev_len = 0;
+    e->input_pos = 0;
+    e->codes_out = 0;
+    e->checkpoint = -1;
+    return;
+}
+
+
+// the dictionary is reset, not created again
+void encoder_reset(Encoder e){
+    assert(e != NULL);
+
+    e->d = dictionary_reset(e->d);
+    encoder_restart(e);
+    return;
+}
+
+
+// the bit writer is owned by the caller
+Encoder encoder_destroy(Encoder e){
+    assert(e != NULL);
+
+    dictionary_destroy(e->d);
+    if (e->huffman != NULL){
+        huffman_block_destroy(e->huffman);
+    }
+    if (e->pending != NULL){
+        free(e->pending);
+    }
+    free(e);
+    e = NULL;
+    return e;
+}
+
+
+// fixed bits (BITS unless the dictionary is set shorter), or into the huffman block
+void encoder_print(Encoder e, const CodeWord cw){
+    assert(e != NULL);
+
+    e->codes_out += 1;
+
+    if (e->huffman == NULL){
+        bit_writer_put(e->bw, cw, e->d->bits);
+        return;
+    }
+
+    huffman_block_put(e->huffman, cw);
+    if (cw == INDEX_REFLUSH || cw == INDEX_EOF || huffman_block_is_full(e->huffman)){
+        huffman_block_print(e->huffman, e->bw);
+    }
+
+    return;
+}
+
+
+// finish all output first, then print index for reflush
+// and clear the dictionary
+void encoder_reflush(Encoder e){
+    assert(e != NULL);
+
+    if (e->prev != -1){
+        encoder_print(e, e->prev);
+        e->prev = -1;
+    }
+
+    encoder_print(e, INDEX_REFLUSH);
+    e->d = dictionary_reset(e->d);
+    e->checkpoint = -1;
+
+    // LZMW / LZAP, the pending chars are walked again in the new dictionary
+    e->last = -1;
+    e->node = -1;
+    e->walked = 0;
+    e->prev_len = 0;
+
+    // a new segment starts here, from the first char not printed yet
+    if (e->index != NULL){
+        segment_index_insert(e->index, bit_writer_tell(e->bw), e->input_pos - e->pending_len);
+    }
+
+    return;
+}
+
+
+// RESET_RATIO, called after a codeword is printed with a full dictionary.
+// like compress(1), look at the ratio every RATIO_CHECK_GAP input chars,
+// but only over the chars since the last check, so that it follows the 
+// recent data. keep the dictionary as long as the output bits per input 
+// char is not clearly worse than the best seen since it became full.
+void encoder_check_ratio(Encoder e){
+    assert(e != NULL);
 
-    // output codeword cw into a 12 bits
+    // the same for every coder, the huffman blocks are printed much later
+    long bits = e->codes_out * BITS;
 
-    // while cw has not been printed into 12 bits, continue
-    while (cw_position > 0){
-        *b <<= 1;       // left shift 1 position
-        mask = (1 << (cw_position - 1));
-        *b |= ((cw & mask) >> (cw_position - 1));
+    // just became full, start the first window
+    if (e->checkpoint == -1){
+        e->checkpoint = e->input_pos + RATIO_CHECK_GAP;
+        e->window_bits = bits;
+        e->window_input = e->input_pos;
+        e->best = -1;
+        return;
+    }
+
+    if (e->input_pos < e->checkpoint){
+        return;
+    }
 
-        cw_position -= 1;
-        *b_position += 1;
+    // bits per input char, scaled by 256
+    long ratio = (bits - e->window_bits) * 256 / (e->input_pos - e->window_input);
 
-        if (*b_position == 8){
-            putc(*b, fp);
-            *b_position = 0;
-            *b = 0;
+    if (e->best != -1 && ratio > e->best + e->best / RATIO_TOLERANCE){
+        encoder_reflush(e);
+        return;
+    }
+
+    if (e->best == -1 || ratio < e->best){
+        e->best = ratio;
+    }
+
+    e->checkpoint = e->input_pos + RATIO_CHECK_GAP;
+    e->window_bits = bits;
+    e->window_input = e->input_pos;
+    return;
+}
+
+
+// if full, follow the policy
+void encoder_check_full(Encoder e){
+    if (dictionary_is_full(e->d)){
+        if (e->policy == RESET_FULL){
+            encoder_reflush(e);
+        }
+        else if (e->policy == RESET_RATIO){
+            encoder_check_ratio(e);
         }
     }
 
@@ -53,33 +260,284 @@ void print_to_file(FILE* fp, int* b, int* b_position, const CodeWord cw){
 }
 
 
-// pad the remaining bits in the buffer, and print out.
-// if no remaining bits, then do nothing. 
-void final_print_to_file(FILE* fp, int* b, int* b_position){
-    if (*b_position != 0){
-        *b <<= (8 - *b_position);
-        putc(*b, fp);
-        
-        *b = 0;
-        *b_position = 0;
+// print the phrase, grow the dictionary with it, and 
+// start the next phrase with the chars after it
+void encoder_print_phrase(Encoder e){
+    encoder_print(e, e->prev);
+    dictionary_grow(e->d, e->last, e->prev);
+    e->last = e->prev;
+
+    e->pending_len -= e->prev_len;
+    memmove(e->pending, e->pending + e->prev_len, e->pending_len);
+
+    e->node = -1;
+    e->walked = 0;
+    e->prev = -1;
+    e->prev_len = 0;
+
+    encoder_check_full(e);
+    return;
+}
+
+
+// walk the pending chars as far as the dictionary goes, the phrase is 
+// the longest code on the way. LZMW has nodes which are not phrases, 
+// so the walk can go further than the phrase, and the chars after the 
+// phrase are walked again. with finish, print everything pending
+void encoder_walk(Encoder e, const bool finish){
+    CodeWord next;
+    CodeWord code;
+
+    while (true){
+        while (e->walked < e->pending_len){
+            next = dictionary_search(e->d, e->node, e->pending[e->walked]);
+            if (next == -1){
+                break;
+            }
+
+            e->node = next;
+            e->walked += 1;
+            code = dictionary_code(e->d, next);
+            if (code != -1){
+                e->prev = code;
+                e->prev_len = e->walked;
+            }
+        }
+
+        // wait for more chars, unless the walk has failed or at the end
+        if (e->walked == e->pending_len && (! finish || e->prev == -1)){
+            return;
+        }
+
+        encoder_print_phrase(e);
     }
+}
+
+
+// after every insert, check if the dictionary is full
+// if full, follow the policy
+void encoder_put(Encoder e, const int c){
+    assert(e != NULL);
 
+    e->input_pos += 1;
+
+    // LZMW / LZAP, the phrases are found by walking the pending chars
+    if (e->growth != GROWTH_LZW){
+        e->pending[e->pending_len] = c;
+        e->pending_len += 1;
+        encoder_walk(e, false);
+        return;
+    }
+
+    // if dictionary contains prev+c, prev = prev + c
+    CodeWord cw = dictionary_search(e->d, e->prev, c);
+    if (cw != -1){
+        e->prev = cw;
+        return;
+    }
+
+    encoder_add(e, c);
     return;
 }
 
 
-// printout the compression ratio
-void compress_stats(const char* original, const char* compressed){
-    // print out the file size change, and calculate the compress ratio
-    FILE* before = open_file_for_read(original);
-    FILE* after = open_file_for_read(compressed);
+// the common case, the match goes on, stays in this loop
+void encoder_put_bytes(Encoder e, const unsigned char* bytes, long len){
+    assert(e != NULL && bytes != NULL);
+
+    if (e->growth != GROWTH_LZW){
+        for (long i = 0; i < len; i++){
+            encoder_put(e, bytes[i]);
+        }
+        return;
+    }
+
+    CodeWord cw;
+    for (long i = 0; i < len; i++){
+        e->input_pos += 1;
+
+        cw = dictionary_search(e->d, e->prev, bytes[i]);
+        if (cw != -1){
+            e->prev = cw;
+        }
+        else{
+            encoder_add(e, bytes[i]);
+        }
+    }
+
+    return;
+}
+
+
+void encoder_add(Encoder e, const int c){
+    // first output code(prev)
+    encoder_print(e, e->prev);
+
+    // add prev+c to dictionary, a full dictionary only takes it with RESET_LRU
+    dictionary_insert(e->d, e->prev, c);
+
+    // prev = c
+    e->prev = c;
+
+    encoder_check_full(e);
+    return;
+}
+
+
+// output the last codeword code(prev), and then the end code
+void encoder_finish(Encoder e, const CodeWord end_code){
+    assert(e != NULL);
+    assert(end_code == INDEX_EOF || end_code == INDEX_REFLUSH);
+
+    if (e->growth != GROWTH_LZW){
+        encoder_walk(e, true);
+    }
+
+    // prev is -1 for an empty input, or right after a reflush
+    if (e->prev != -1){
+        encoder_print(e, e->prev);
+        e->prev = -1;
+    }
 
-    fseek(before, 0L, SEEK_END);
-    fseek(after, 0L, SEEK_END);
+    encoder_print(e, end_code);
+    return;
+}
+
+
+// each thread compress its own segment into memory
+// the segment ends with reflush, and more reflush codes are added until
+// the output is a whole byte, so that the segments can be simply joined.
+// codewords are BITS bits, so at most 8 codes (4 for an even BITS) are needed
+// a huffman block is always a whole byte, so nothing is added
+void* compress_segment(void* arg){
+    Segment sg = (Segment) arg;
+    assert(sg != NULL && sg->bw != NULL);
+
+    Encoder e = encoder_create(sg->bw, sg->index, sg->h);
+
+    encoder_put_bytes(e, sg->input, sg->input_len);
+
+    encoder_finish(e, INDEX_REFLUSH);
+    while (! bit_writer_is_aligned(sg->bw)){
+        print_to_file(sg->bw, INDEX_REFLUSH);
+    }
+    bit_writer_flush(sg->bw);
+
+    encoder_destroy(e);
+    return NULL;
+}
+
+
+// read "threads" segments, compress them at the same time, print them in order,
+// and repeat until the end of the file.
+// at last, print the pesudo index eof on its own
+long compress_parallel(FILE* fp, BitWriter bw, int threads, SegmentIndex index, const Header h){
+    assert(fp != NULL && bw != NULL);
+    assert(threads >= 1);
+    assert(bit_writer_is_aligned(bw));
+
+    struct _Segment* segments = (struct _Segment*) malloc(threads * sizeof(struct _Segment));
+    pthread_t* tids = (pthread_t*) malloc(threads * sizeof(pthread_t));
+    assert(segments != NULL && tids != NULL);
+
+    for (int i = 0; i < threads; i++){
+        segments[i].input = io_buffer_create(SEGMENT_SIZE);
+        segments[i].h = h;
+    }
+
+    bool finish = false;
+    int running;
+
+    // input position of the next segment
+    long input_offset = 0;
+
+    while (! finish){
+        // read and start
+        running = 0;
+        while (running < threads && ! finish){
+            Segment sg = &segments[running];
+            sg->input_len = fread(sg->input, 1, SEGMENT_SIZE, fp);
+
+            if (sg->input_len < SEGMENT_SIZE){
+                finish = true;
+            }
+
+            if (sg->input_len > 0){
+                sg->bw = bit_writer_create(NULL);
+                sg->index = (index != NULL) ? segment_index_create() : NULL;
+                pthread_create(&tids[running], NULL, compress_segment, sg);
+                running += 1;
+            }
+        }
 
-    long before_size = ftell(before);
-    long after_size = ftell(after);
+        // wait and print in order
+        for (int i = 0; i < running; i++){
+            Segment sg = &segments[i];
+            pthread_join(tids[i], NULL);
+            long bit_offset = bit_writer_tell(bw);
+            bit_writer_put_bytes(bw, sg->bw->buffer, sg->bw->buffer_len);
 
+            // segment start, and the reflush points inside, moved by the segment position
+            if (index != NULL){
+                segment_index_insert(index, bit_offset, input_offset);
+                for (long j = 0; j < sg->index->count; j++){
+                    segment_index_insert(index, 
+                        bit_offset + sg->index->bit_offsets[j], 
+                        input_offset + sg->index->input_offsets[j]
+                    );
+                }
+                segment_index_destroy(sg->index);
+            }
+
+            input_offset += sg->input_len;
+            bit_writer_destroy(sg->bw);
+        }
+    }
+
+    // the pesudo index eof, through an encoder for the coder
+    Encoder e = encoder_create(bw, NULL, h);
+    encoder_finish(e, INDEX_EOF);
+    encoder_destroy(e);
+
+    for (int i = 0; i < threads; i++){
+        free(segments[i].input);
+    }
+    free(segments);
+    free(tids);
+
+    return input_offset;
+}
+
+
+// all numbers are printed msb first, 64 bits for offsets and 32 bits for count
+void print_index_to_file(BitWriter bw, const SegmentIndex index, long input_size){
+    assert(bw != NULL && index != NULL);
+    assert(bit_writer_is_aligned(bw));
+
+    for (long i = 0; i < index->count; i++){
+        bit_writer_put(bw, (uint64_t) index->bit_offsets[i] >> 32, 32);
+        bit_writer_put(bw, (uint64_t) index->bit_offsets[i], 32);
+        bit_writer_put(bw, (uint64_t) index->input_offsets[i] >> 32, 32);
+        bit_writer_put(bw, (uint64_t) index->input_offsets[i], 32);
+    }
+
+    bit_writer_put(bw, (uint64_t) input_size >> 32, 32);
+    bit_writer_put(bw, (uint64_t) input_size, 32);
+    bit_writer_put(bw, index->count, 32);
+
+    bit_writer_put(bw, 'L', 8);
+    bit_writer_put(bw, 'Z', 8);
+    bit_writer_put(bw, 'W', 8);
+    bit_writer_put(bw, 'I', 8);
+
+    bit_writer_flush(bw);
+    return;
+}
+
+
+// printout the compression ratio
+void compress_stats(const char* original, const char* compressed, long before_size, long after_size){
+    // print out the file size change, and calculate the compress ratio
     fprintf(stdout, "LZW compression statistics:\n");
 
     fprintf(
@@ -97,7 +555,5 @@ void compress_stats(const char* original, const char* compressed){
         "Space saving: %.2f%%\n", ((float)1 - (float)after_size / before_size)*100
     );
 
-    close_file(before);
-    close_file(after);
     return;
 }   
\ No newline at end of file
@@ -5,18 +5,98 @@
 #include <stdlib.h>
 #include "file.h"
 #include "data_structure.h"
+#include "huffman.h"
 #include "util.h"
 
+
+// input size for each segment of the parallel compression
+// every segment starts with an empty dictionary
+#define SEGMENT_SIZE (1 << 20)
+
+
+// RESET_RATIO, once the dictionary is full check the ratio every 
+// RATIO_CHECK_GAP input chars, and reflush if the bits per char is 
+// more than 1 / RATIO_TOLERANCE worse than the best so far
+#define RATIO_CHECK_GAP 10000
+#define RATIO_TOLERANCE 16
+
+
+// the encoder state carried from one input char to the next
+struct _Encoder{
+    Dictionary d;
+    BitWriter bw;
+    CodeWord prev;      // codeword of the current match, -1 before the first char
+    long input_pos;     // number of chars read so far
+    SegmentIndex index; // record every reflush point, NULL if not needed
+    int policy;         // what to do when the dictionary is full
+    int growth;         // how the dictionary grows after each phrase
+    HuffmanBlock huffman;   // CODER_HUFFMAN only, the codewords not printed yet
+    long codes_out;     // number of codewords printed so far
+
+    // RESET_RATIO only, the window since the last check
+    long checkpoint;    // input position of the next check, -1 if not full yet
+    long window_bits;
+    long window_input;
+    long best;          // best bits per char * 256, -1 if no window yet
+                        // counted as BITS bits per codeword for every coder
+
+    // GROWTH_LZMW and GROWTH_LZAP only, prev is the longest code walked so far
+    CodeWord last;          // the phrase printed before, -1 after a reflush
+    CodeWord node;          // where the walk is in the dictionary, -1 at the start
+    unsigned char* pending; // chars read but not printed yet
+    long pending_len;
+    long walked;            // number of pending chars walked
+    long prev_len;          // number of pending chars in prev
+};
+typedef struct _Encoder* Encoder;
+
 // create the output file name, add .LZW at the end
 char* create_compressed_file_name(const char* original);
 
-// output this byte to the file, use pointer to transfer information
-void print_to_file(FILE* fp, int* b, int* b_position, const CodeWord cw);
+// output this codeword to the file through the bit writer
+void print_to_file(BitWriter bw, const CodeWord cw);
 
 // output the last byte, pad if necessary
-void final_print_to_file(FILE* fp, int* b, int* b_position);
+void final_print_to_file(BitWriter bw);
+
+// encoder create and destroy, output goes to the bit writer
+// the policy and the coder are taken from the header
+// index can be NULL, otherwise the encoder adds each reflush point to it
+Encoder encoder_create(BitWriter bw, SegmentIndex index, const Header h);
+Encoder encoder_destroy(Encoder);
+
+// start a new input from an empty dictionary, without allocating,
+// the huffman block must be empty (after eof)
+void encoder_reset(Encoder);
+
+// output a codeword with the coder of the encoder
+// for CODER_HUFFMAN, the block is printed when full, or after reflush and eof
+void encoder_print(Encoder, const CodeWord cw);
+
+// feed one input char, output a codeword if the match ends here
+void encoder_put(Encoder, const int c);
+
+// feed a block of input chars, the same as encoder_put for each
+void encoder_put_bytes(Encoder, const unsigned char* bytes, long len);
+
+// output the last match and then the end code, INDEX_EOF or INDEX_REFLUSH
+void encoder_finish(Encoder, const CodeWord end_code);
+
+// compress fp into bw with "threads" threads, 
+// each SEGMENT_SIZE input block is compressed independently with its own
+// dictionary, ends with reflush and is padded to a whole byte.
+// the pesudo index eof is printed at the end.
+// if index is not NULL, record the start of every segment
+// return the input size
+long compress_parallel(FILE* fp, BitWriter bw, int threads, SegmentIndex index, const Header h);
+
+// print the segment index after the pesudo eof, the decoder never reads 
+// beyond eof, so the file is still valid without the index.
+// layout: (bit offset, input offset) * count, input size, count, "LZWI"
+void print_index_to_file(BitWriter bw, const SegmentIndex index, long input_size);
 
 // print the compression status, including compression ratio
-void compress_stats(const char* original, const char* compressed);
+// the sizes are counted while reading and writing
+void compress_stats(const char* original, const char* compressed, long before_size, long after_size);
 
 #endif
\ No newline at end of file
@@ -6,65 +6,98 @@
 
 
 // define the hash table capacity
-// 4096 (12 bits) * capacity factor
+// 4096 (12 bits) * 2
 // in order to reduce hash collision
-#define CAPACITY (SIZE_LIMIT * CAPACITY_FACTOR)
+#define CAPACITY(d) ((Index) 1 << (d)->capacity_bits)
 
-// dictionary, create an empty node
-Node node_create(const Key k, const CodeWord cw, Node next);
+// root table, one entry per char + char
+#define ROOT_SIZE (256 * 256)
 
-// dictionary, delete the node
-Node node_delete(Node);
+// dictionary, the slot is empty if its stamp is from an older generation
+bool dictionary_slot_is_live(const Dictionary d, const Index hidx);
+// dictionary, find the slot of an existing entry
+Index dictionary_find_slot(const Dictionary d, const CodeWord cw);
+// dictionary, empty a slot and move the following entries back
+void dictionary_remove_slot(Dictionary d, Index hidx);
+// dictionary, take an entry out of the root table or the hash table
+void dictionary_remove(Dictionary d, const CodeWord cw);
 
+// GROWTH_LZMW, the node of a codeword, and give the next codeword to a node
+CodeWord dictionary_node(const Dictionary d, const CodeWord cw);
+CodeWord dictionary_add_code(Dictionary d, const CodeWord node);
 
-// calculate the hash value
-Index calculate_index(const char* s){
-    assert(s != NULL);
+// insert the seed entries after a reset
+void dictionary_load_seed(Dictionary d);
+void array_load_seed(Array a);
 
-    Index val = 0;
-    int ch;
+// recency list, append to the end or remove
+void recency_append(Recency r, const Index cw);
+void recency_unlink(Recency r, const Index cw);
+// the prefix gets one more child, it is no longer a leaf
+void recency_add_child(Recency r, const Index prefix);
 
-    // iterate around the string, extract char one by one
-    while (*s != '\0'){
-        // extract this char, make sure it is positive
-        ch = *s;
-        if (ch < 0){
-            ch += 256;
-        }
 
-        // left shift the last value and then add the new char
-        val = (val << 3) + ch;
-        // move to the next char
-        s += 1;         
-    }
+// calculate the hash value
+// multiplicative hash of prefix + char, the top bits are the most mixed
+Index calculate_index(const CodeWord prefix, const int c, const int bits){
+    assert(prefix >= 0 && c >= 0 && c <= 255);
 
-    // extract the index, index must be >= 0 
-    val = val % CAPACITY;
-    
-    while (val < 0){
-        val += CAPACITY;
-    }
-    
-    return val;
+    uint32_t key = ((uint32_t) prefix << 8) | (uint32_t) c;
+    return (Index) ((uint32_t) (key * 2654435761u) >> (32 - bits));
 }
 
 
-// create the dictionary, insert 256 chars + 1 for EOF and 1 for reflux
-// so that the 256 and 257 index are reserved
+// create the dictionary, 256 chars + 1 for EOF and 1 for reflux
+// are not stored, so that the 256 and 257 index are reserved
 // size = 4096, current_num = 258, so next index start at 258 during insert
-Dictionary dictionary_create(void){
+// GROWTH_LZMW has NODE_LIMIT nodes, and the maps between nodes and codewords
+Dictionary dictionary_create(const int policy, const int growth){
     Dictionary d = (struct _Dictionary*) malloc (sizeof(struct _Dictionary));
     assert(d != NULL);
 
-    d->nodes = (Node*) malloc (CAPACITY * sizeof(Node));
-    assert(d->nodes != NULL);
+    d->policy = policy;
+    d->growth = growth;
+    d->recency = NULL;
+
+    if (policy == RESET_LRU){
+        d->recency = recency_create();
+    }
 
-    for (Index i = 0; i < CAPACITY; i++){
-        d->nodes[i] = NULL;
+    d->node_limit = SIZE_LIMIT;
+    d->capacity_bits = CAPACITY_BITS;
+    d->code = NULL;
+    d->node = NULL;
+
+    if (growth == GROWTH_LZMW){
+        d->node_limit = NODE_LIMIT;
+        d->capacity_bits = NODE_BITS + 1;
+        d->code = (Code*) malloc (NODE_LIMIT * sizeof(Code));
+        d->node = (Code*) malloc (SIZE_LIMIT * sizeof(Code));
+        assert(d->code != NULL && d->node != NULL);
     }
 
-    // fill the hash table with initial values 0 - 255
-    d->current_num = 256 + 2; // initially 256 char + 1 for EOF + 1 for reflush   
+    d->prefix = (Code*) malloc (d->node_limit * sizeof(Code));
+    d->suffix = (unsigned char*) malloc (d->node_limit * sizeof(unsigned char));
+    d->slots = (Code*) malloc (CAPACITY(d) * sizeof(Code));
+    d->stamps = (Generation*) calloc (CAPACITY(d), sizeof(Generation));
+    d->root = (Code*) malloc (ROOT_SIZE * sizeof(Code));
+    d->root_stamps = (Generation*) calloc (ROOT_SIZE, sizeof(Generation));
+    d->buffer = (unsigned char*) malloc (d->node_limit * sizeof(unsigned char));
+    assert(d->prefix != NULL && d->suffix != NULL);
+    assert(d->slots != NULL && d->stamps != NULL);
+    assert(d->root != NULL && d->root_stamps != NULL);
+    assert(d->buffer != NULL);
+
+    // stamp 0 is never live
+    d->generation = 1;
+
+    // initially 256 char + 1 for EOF + 1 for reflush   
+    d->current_num = 256 + 2;
+    d->node_num = 256 + 2;
+    d->limit = SIZE_LIMIT;
+    d->bits = BITS;
+    d->seed = NULL;
+    d->seed_loaded = false;
 
     return d;
 }
@@ -74,15 +107,23 @@ Dictionary dictionary_create(void){
 Dictionary dictionary_destroy(Dictionary d){
     assert(d != NULL);
 
-    // use recursion to free all nodes
-    for (Index i = 0; i < CAPACITY; i++){
-        if (d->nodes[i] != NULL){
-            node_delete(d->nodes[i]);
-        }
+    free(d->prefix);
+    free(d->suffix);
+    free(d->slots);
+    free(d->stamps);
+    free(d->root);
+    free(d->root_stamps);
+    free(d->buffer);
+
+    if (d->growth == GROWTH_LZMW){
+        free(d->code);
+        free(d->node);
+    }
+
+    if (d->policy == RESET_LRU){
+        recency_destroy(d->recency);
     }
 
-    free(d->nodes);
-    d->nodes = NULL;
     free(d);
     d = NULL;
     return d;
@@ -91,188 +132,390 @@ Dictionary dictionary_destroy(Dictionary d){
 
 // reset dictionary if it is full,
 // to reflect more local characteristics. 
-// reset = destroy + create
+// only the generation is moved on, all slots become empty at once,
+// but the seed entries, stamped SEED_STAMP, stay
 Dictionary dictionary_reset(Dictionary d){
     assert(d != NULL);
-    d = dictionary_destroy(d);
-    d = dictionary_create();
+
+    d->generation += 1;
+
+    // wrap around, the old stamps could look live again, 
+    // so clear them for real, once every 65534 resets
+    if (d->generation == SEED_STAMP){
+        memset(d->stamps, 0, CAPACITY(d) * sizeof(Generation));
+        memset(d->root_stamps, 0, ROOT_SIZE * sizeof(Generation));
+        d->generation = 1;
+        d->seed_loaded = false;
+    }
+
+    d->current_num = 256 + 2;
+    d->node_num = 256 + 2;
+
+    if (d->policy == RESET_LRU){
+        recency_reset(d->recency);
+    }
+
+    dictionary_load_seed(d);
     return d;
 }
 
 
+void dictionary_set_seed(Dictionary d, const Seed seed){
+    assert(d != NULL);
+    assert(d->current_num == INDEX_FIRST);
+    assert(seed == NULL || seed->count <= d->limit / 2);
+
+    d->seed = seed;
+    dictionary_load_seed(d);
+    return;
+}
+
+
+// the tables keep their size, only the limit is lower
+void dictionary_set_bits(Dictionary d, const int bits){
+    assert(d != NULL && d->seed == NULL);
+    assert(bits >= MIN_BITS && bits <= BITS);
+
+    d->bits = bits;
+    d->limit = (Index) 1 << bits;
+    return;
+}
+
+
+// the seed entries take the first codewords, in order.
+// RESET_LRU can replace them, so they are inserted again after each reset, 
+// otherwise they are inserted once and kept with a stamp that never expires
+void dictionary_load_seed(Dictionary d){
+    if (d->seed == NULL){
+        return;
+    }
+
+    if (d->seed_loaded){
+        d->current_num = INDEX_FIRST + d->seed->count;
+        d->node_num = d->current_num;
+        return;
+    }
+
+    // every seed entry is a code, so the node is the codeword for LZMW too
+    for (long i = 0; i < d->seed->count; i++){
+        CodeWord cw = dictionary_insert(d, d->seed->prefix[i], d->seed->suffix[i]);
+        if (d->growth == GROWTH_LZMW){
+            cw = dictionary_add_code(d, cw);
+        }
+        assert(cw == INDEX_FIRST + i);
+
+        if (d->policy != RESET_LRU){
+            if (d->prefix[cw] < 256){
+                d->root_stamps[(d->prefix[cw] << 8) | d->suffix[cw]] = SEED_STAMP;
+            }
+            else{
+                d->stamps[dictionary_find_slot(d, cw)] = SEED_STAMP;
+            }
+        }
+    }
+
+    d->seed_loaded = (d->policy != RESET_LRU);
+    return;
+}
+
+
 // check if is full, if full, need reset
 bool dictionary_is_full(Dictionary d){
     assert(d != NULL);
 
     // note that the capacity is a multiple of 4096
     // but when we reach 4096 items, we do the reflush !!!
-    return d->current_num == SIZE_LIMIT;
+    // LZMW can also run out of nodes first
+    return d->current_num == d->limit || d->node_num == d->node_limit;
 }
 
 
-// check if the key exist, 
-// if exist return the index, if not return -1 
-CodeWord dictionary_search(Dictionary d, const Key k){
-    assert(d != NULL && k != NULL);
+// live if stamped with the current generation
+bool dictionary_slot_is_live(const Dictionary d, const Index hidx){
+    return d->stamps[hidx] == d->generation || d->stamps[hidx] == SEED_STAMP;
+}
 
-    CodeWord result;
 
-    // if it is a single char, simply return its int
-    if (strlen(k) == 1){
-        int idx = k[0];
-        if (idx < 0){
-            idx += 256;
-        }
-        
-        result = idx;
+// check if prefix + c exist, 
+// if exist return the codeword, if not return -1 
+CodeWord dictionary_search(Dictionary d, const CodeWord prefix, const int c){
+    assert(d != NULL);
+
+    // a single char is its own codeword
+    if (prefix == -1){
+        return c;
     }
-    else{
-        // for string of length >= 2
-        Index hidx = calculate_index(k);
-        if (d->nodes[hidx] == NULL){
-            result = -1;
+
+    // 2 chars, no hash
+    if (prefix < 256){
+        Index ridx = (prefix << 8) | c;
+        Generation stamp = d->root_stamps[ridx];
+        return (stamp == d->generation || stamp == SEED_STAMP) ? d->root[ridx] : -1;
+    }
+
+    // probe until an empty slot
+    Index mask = CAPACITY(d) - 1;
+    Index hidx = calculate_index(prefix, c, d->capacity_bits);
+    while (dictionary_slot_is_live(d, hidx)){
+        Code cw = d->slots[hidx];
+        if (d->prefix[cw] == prefix && d->suffix[cw] == c){
+            return cw;
         }
-        else{
-            // if see the exact key, then return the index
-            Node n = d->nodes[hidx];
-            while (n != NULL && strcmp(n->k, k) != 0){
-                n = n->next;
-            }
+        hidx = (hidx + 1) & mask;
+    }
 
-            if (n == NULL){
-                result = -1;
-            }
-            else{
-                result = n->cw;   // find the key, return the codeword
-            }
+    return -1;
+}
+
+
+// the entry is known to be in the table
+Index dictionary_find_slot(const Dictionary d, const CodeWord cw){
+    Index hidx = calculate_index(d->prefix[cw], d->suffix[cw], d->capacity_bits);
+    while (d->slots[hidx] != cw){
+        assert(dictionary_slot_is_live(d, hidx));
+        hidx = (hidx + 1) & (CAPACITY(d) - 1);
+    }
+    return hidx;
+}
+
+
+// linear probing can not leave a hole, so move back every following 
+// entry which would not be found any more, until an empty slot
+void dictionary_remove_slot(Dictionary d, Index hidx){
+    Index mask = CAPACITY(d) - 1;
+    Index next = (hidx + 1) & mask;
+
+    while (dictionary_slot_is_live(d, next)){
+        Code cw = d->slots[next];
+        Index home = calculate_index(d->prefix[cw], d->suffix[cw], d->capacity_bits);
+
+        // the entry can move to the hole if its home is not between them
+        bool can_move = (hidx <= next) ? (home <= hidx || home > next)
+                                       : (home <= hidx && home > next);
+        if (can_move){
+            d->slots[hidx] = cw;
+            hidx = next;
         }
+        next = (next + 1) & mask;
     }
 
-    return result;
+    d->stamps[hidx] = 0;
+    return;
 }
 
 
-// insert key-cw pair into the dictionary
-// if hash index position is null, insert
-// if not null, find the end of the linked table, then insert
-CodeWord dictionary_insert(Dictionary d, const Key k){
-    assert(d != NULL && k != NULL);
+// a single char prefix is in the root table, the others are hashed
+void dictionary_remove(Dictionary d, const CodeWord cw){
+    if (d->prefix[cw] < 256){
+        d->root_stamps[(d->prefix[cw] << 8) | d->suffix[cw]] = 0;
+    }
+    else{
+        dictionary_remove_slot(d, dictionary_find_slot(d, cw));
+    }
+    return;
+}
+
 
-    // calculate the hash index
-    Index hidx = calculate_index(k);
-    assert(hidx >= 0);
+// insert prefix + c into the dictionary
+// take the next codeword, or with RESET_LRU when full the oldest leaf
+// then put it in the root table, or the first empty slot from the hash index
+// LZMW only takes the next node, dictionary_grow gives the codeword
+CodeWord dictionary_insert(Dictionary d, const CodeWord prefix, const int c){
+    assert(d != NULL && prefix >= 0);
 
     // assign the codeword
-    CodeWord cw = d->current_num;       
+    CodeWord cw;
 
-    if (d->nodes[hidx] == NULL){
-        d->nodes[hidx] = node_create(k, cw, NULL);
+    if (! dictionary_is_full(d) && d->growth == GROWTH_LZMW){
+        cw = d->node_num;
+        d->node_num += 1;
+        d->code[cw] = 0;
     }
-    else{
-        Node n = d->nodes[hidx];
-        while (n->next != NULL){
-            n = n->next;
+    else if (! dictionary_is_full(d)){
+        cw = d->current_num;
+        d->current_num += 1;    // update the counter
+        d->node_num = d->current_num;
+
+        if (d->policy == RESET_LRU){
+            recency_add(d->recency, cw, prefix);
         }
-        n->next = node_create(k, cw, NULL);
     }
+    else if (d->policy == RESET_LRU){
+        // reuse the codeword of the oldest leaf
+        cw = recency_replace(d->recency, prefix);
+        if (cw == -1){
+            return cw;
+        }
+
+        // remove the old entry from the tables
+        dictionary_remove(d, cw);
+    }
+    else{
+        return -1;
+    }
+
+    d->prefix[cw] = prefix;
+    d->suffix[cw] = c;
+
+    if (prefix < 256){
+        Index ridx = (prefix << 8) | c;
+        d->root[ridx] = cw;
+        d->root_stamps[ridx] = d->generation;
+        return cw;
+    }
+
+    Index hidx = calculate_index(prefix, c, d->capacity_bits);
+    while (dictionary_slot_is_live(d, hidx)){
+        hidx = (hidx + 1) & (CAPACITY(d) - 1);
+    }
+
+    d->slots[hidx] = cw;
+    d->stamps[hidx] = d->generation;
 
-    // update the counter
-    d->current_num += 1;
     return cw;
 }
 
 
-// debug use: print the dictionary
-void dictionary_print(Dictionary d){
-    assert(d != NULL);
+// a char is its own node
+CodeWord dictionary_code(const Dictionary d, const CodeWord node){
+    assert(d != NULL && node >= 0 && node < d->node_num);
 
-    fprintf(stdout, "-----Dictionary print-----\n");
-    fprintf(stdout, "Size = %d, current_num = %ld\n", SIZE_LIMIT, d->current_num);
+    if (d->growth != GROWTH_LZMW || node < INDEX_FIRST){
+        return node;
+    }
+    return (d->code[node] == 0) ? -1 : d->code[node];
+}
 
-    for (Index i = 0; i < CAPACITY; i++){
 
-        if (i <= 255){
-            // single char range
-            fprintf(stdout, "[%ld] %c => %ld ", i, (int)i, i);
-            if (d->nodes[i] != NULL){
-                Node n = d->nodes[i];
-                while (n != NULL){
-                    fprintf(stdout, "%s => %ld ", n->k, n->cw);
-                    n = n->next;
-                }
-            }
-            fprintf(stdout, "\n");
-        }
-        else if (d->nodes[i] != NULL){
-            Node n = d->nodes[i];
-            fprintf(stdout, "[%ld]  ", i);
-            while (n != NULL){
-                fprintf(stdout, "%s => %ld ", n->k, n->cw);
-                n = n->next;
-            }
-            fprintf(stdout, "\n");
-        }
+CodeWord dictionary_node(const Dictionary d, const CodeWord cw){
+    if (d->growth != GROWTH_LZMW || cw < INDEX_FIRST){
+        return cw;
     }
+    return d->node[cw];
+}
 
-    fprintf(stdout, "-----End-----\n");
-    return;
+
+// the caller checks there is a codeword left
+CodeWord dictionary_add_code(Dictionary d, const CodeWord node){
+    assert(d->current_num < d->limit);
+
+    CodeWord cw = d->current_num;
+    d->current_num += 1;
+    d->code[node] = cw;
+    d->node[cw] = node;
+    return cw;
 }
 
 
-// create a node, initialize with NULL next pointer
-Node node_create(const Key k, const CodeWord cw, Node next){
-    Node n = (Node) malloc (sizeof(struct _Node));
-    assert(n != NULL);
+// rebuilt backwards from the end of the buffer, 
+// a string is at most as long as the number of entries
+unsigned char* dictionary_string(Dictionary d, const CodeWord cw, long* length){
+    assert(d != NULL && length != NULL);
+    assert(cw >= 0 && cw < d->current_num && cw != INDEX_EOF && cw != INDEX_REFLUSH);
+
+    long pos = d->node_limit;
+    CodeWord n = dictionary_node(d, cw);
 
-    // allocate memory
-    n->k = (char*)malloc((strlen(k)+1)*sizeof(char)); // add 1 for \0
-    assert(n->k != NULL);
-    // copy the key
-    strcpy(n->k, k);
+    while (n >= INDEX_FIRST){
+        pos -= 1;
+        d->buffer[pos] = d->suffix[n];
+        n = d->prefix[n];
+    }
 
-    // create the index and next pointer
-    n->cw = cw;
-    n->next = next;
+    pos -= 1;
+    d->buffer[pos] = n;
 
-    return n;
+    *length = d->node_limit - pos;
+    return d->buffer + pos;
 }
 
 
-// recursive to delete all nodes of the dictionary
-Node node_delete(Node n){
-    if (n == NULL){
-        return n;
+// walk from prev with the chars of cw, add every entry not there yet.
+// LZAP: all of them are codes.
+// LZMW: only the last one (prev + cw) gets a codeword, the others are  
+// only nodes, so that the encoder can walk to it one char at a time.
+void dictionary_grow(Dictionary d, const CodeWord prev, const CodeWord cw){
+    assert(d != NULL);
+    assert(d->growth == GROWTH_LZMW || d->growth == GROWTH_LZAP);
+
+    if (prev == -1){
+        return;
     }
-    else{
-        node_delete(n->next);
-        free(n->k);
-        free(n);
-        n = NULL;
-        return n;
+
+    long length;
+    unsigned char* s = dictionary_string(d, cw, &length);
+
+    CodeWord node = dictionary_node(d, prev);
+    CodeWord next;
+
+    for (long i = 0; i < length; i++){
+        next = dictionary_search(d, node, s[i]);
+
+        if (next == -1){
+            next = dictionary_insert(d, node, s[i]);
+            if (next == -1){
+                return;
+            }
+        }
+
+        node = next;
     }
+
+    // the node may be there already, on the way to a longer phrase
+    if (d->growth == GROWTH_LZMW && d->code[node] == 0 && d->current_num < d->limit){
+        dictionary_add_code(d, node);
+    }
+    return;
+}
+
+
+// debug use: print the dictionary, entry by entry
+void dictionary_print(Dictionary d){
+    assert(d != NULL);
+
+    fprintf(stdout, "-----Dictionary print-----\n");
+    fprintf(stdout, "Size = %d, current_num = %ld, node_num = %ld\n", 
+            SIZE_LIMIT, d->current_num, d->node_num);
+
+    for (Index i = INDEX_FIRST; i < d->node_num; i++){
+        fprintf(stdout, "%ld => %d + %c\n", i, d->prefix[i], d->suffix[i]);
+    }
+
+    fprintf(stdout, "-----End-----\n");
+    return;
 }
 
 
 // array functions
 // create
 // 0-255 leaves empty, also reserve 256 for EOF and 257 for Reflush
-Array array_create(void){
+Array array_create(const int policy){
 
     Array a = (struct _Array*) malloc (sizeof(struct _Array));
     assert(a != NULL);
 
+    a->policy = policy;
+    a->recency = NULL;
+    if (policy == RESET_LRU){
+        a->recency = recency_create();
+    }
+
     // occupy the first 258+2 positions, but do not set anything
-    // so that the whole ram usage can be smaller
     a->current_num = 256 + 2;
+    a->limit = SIZE_LIMIT;
+    a->bits = BITS;
+    a->seed = NULL;
+    a->seed_loaded = false;
 
     // here we only need 4096 items
     // since here we do not perform hash, so no hash collision
-    a->nodes = (char**) malloc (SIZE_LIMIT * sizeof(char*));
-    assert(a->nodes != NULL);
-
-    for (Index i = 0; i < SIZE_LIMIT; i++){
-        a->nodes[i] = NULL;
-    }
+    a->prefix = (Code*) malloc (SIZE_LIMIT * sizeof(Code));
+    a->suffix = (unsigned char*) malloc (SIZE_LIMIT * sizeof(unsigned char));
+    a->first = (unsigned char*) malloc (SIZE_LIMIT * sizeof(unsigned char));
+    a->length = (Code*) malloc (SIZE_LIMIT * sizeof(Code));
+    a->buffer = (unsigned char*) malloc (SIZE_LIMIT * sizeof(unsigned char));
+    assert(a->prefix != NULL && a->suffix != NULL && a->first != NULL);
+    assert(a->length != NULL && a->buffer != NULL);
 
     return a;
 }
@@ -282,85 +525,172 @@ Array array_create(void){
 Array array_destroy(Array a){
     assert(a != NULL);
 
-    for (Index i = 0; i < SIZE_LIMIT; i++){
-        if (a->nodes[i] != NULL){
-            free(a->nodes[i]);
-            a->nodes[i] = NULL;
-        }
-    }
+    free(a->prefix);
+    free(a->suffix);
+    free(a->first);
+    free(a->length);
+    free(a->buffer);
 
-    free(a->nodes); 
+    if (a->policy == RESET_LRU){
+        recency_destroy(a->recency);
+    }
     free(a);
     a = NULL;
     return a;
 }
 
 
-// reset = destroy + create
+// entries are only added in order, and only replaced after that, 
+// so everything below current_num is set and a reset is only the counter
 Array array_reset(Array a){
     assert(a != NULL);
 
-    a = array_destroy(a);
-    a = array_create();
+    a->current_num = 256 + 2;
+
+    if (a->policy == RESET_LRU){
+        recency_reset(a->recency);
+    }
+
+    array_load_seed(a);
     return a;
 }
 
 
+void array_set_seed(Array a, const Seed seed){
+    assert(a != NULL);
+    assert(a->current_num == INDEX_FIRST);
+    assert(seed == NULL || seed->count <= a->limit / 2);
+
+    a->seed = seed;
+    array_load_seed(a);
+    return;
+}
+
+
+void array_set_bits(Array a, const int bits){
+    assert(a != NULL && a->seed == NULL);
+    assert(bits >= MIN_BITS && bits <= BITS);
+
+    a->bits = bits;
+    a->limit = (Index) 1 << bits;
+    return;
+}
+
+
+// RESET_LRU can replace a seed entry, so they are set again each time,
+// otherwise they are never written after the first time
+void array_load_seed(Array a){
+    if (a->seed == NULL){
+        return;
+    }
+
+    if (a->seed_loaded && a->policy != RESET_LRU){
+        a->current_num = INDEX_FIRST + a->seed->count;
+        return;
+    }
+
+    for (long i = 0; i < a->seed->count; i++){
+        Index idx = array_reserve(a, a->seed->prefix[i]);
+        assert(idx == INDEX_FIRST + i);
+        array_set(a, idx, a->seed->prefix[i], a->seed->suffix[i]);
+    }
+
+    a->seed_loaded = true;
+    return;
+}
+
+
 // check if full
 bool array_is_full(const Array a){
     assert(a != NULL);
-    return a->current_num == SIZE_LIMIT;
+    return a->current_num == a->limit;
 }
 
 
 // search using index, return the string
-// Key prev is included to avoid the unseen mistake
-// that during compression, the key is created then used straight away
-// without any time gap.
-// Also need to take care with the return key
-// if simply print it, it is fine
-// but if need to modify, make sure use strcpy first
-// do not change on the returned pointer directly
-//
-// malloc and copy for all answers.
-Key array_search(Array a, const Index idx){
-    assert(a != NULL && idx >= 0);
+// the string is rebuilt backwards from the last char in the buffer.
+// do not free the returned pointer, and copy it first if it 
+// is needed after the next search
+unsigned char* array_search(Array a, const Index idx, long* length){
+    assert(a != NULL && length != NULL);
+    assert(array_has_this_codeword(a, idx));
+
+    // a single char
+    if (idx <= 255){
+        a->buffer[0] = idx;
+        *length = 1;
+        return a->buffer;
+    }
 
-    Key result;
+    *length = a->length[idx] + 1;
 
-    // if the index <= 255, create the key and return
-    // since the bucket is actually NULL
-    if (idx <= 255){
-        result = (Key) malloc (2 * sizeof(char));
-        assert(result != NULL);
+    Index cw = idx;
+    for (long i = *length - 1; i > 0; i--){
+        a->buffer[i] = a->suffix[cw];
+        cw = a->prefix[cw];
+    }
+    a->buffer[0] = cw;
+
+    return a->buffer;
+}
+
+
+// first char of the string
+int array_first_char(Array a, const Index idx){
+    assert(a != NULL);
+    assert(array_has_this_codeword(a, idx));
 
-        result[0] = idx;
-        result[1] = '\0';
+    if (idx <= 255){
+        return idx;
     }
-    else{
-        assert(a->nodes[idx] != NULL);
+    return a->first[idx];
+}
 
-        // malloc and then strcmp
-        result = (char*)malloc((strlen(a->nodes[idx])+1)*sizeof(char));
-        assert(result != NULL);
-        strcpy(result, a->nodes[idx]);
+
+// the array grows in order until full, 
+// then RESET_LRU reuses the index of the oldest leaf.
+// must be called before the codeword read is looked up, since
+// the reserved index can be the codeword read (created and used straight away)
+Index array_reserve(Array a, const Index prefix){
+    assert(a != NULL);
+
+    Index idx = -1;
+
+    if (! array_is_full(a)){
+        idx = a->current_num;
+        a->current_num += 1;
+
+        if (a->policy == RESET_LRU){
+            recency_add(a->recency, idx, prefix);
+        }
+    }
+    else if (a->policy == RESET_LRU){
+        idx = recency_replace(a->recency, prefix);
     }
 
-    return result;
+    return idx;
 }
 
 
-// insert, no codeword required, simply insert in first in order
-Index array_insert(Array a, const Key k){
-    assert(a != NULL && k != NULL);
-    assert(! array_is_full(a));
+// set the entry, the first char and length come from the prefix
+void array_set(Array a, const Index idx, const Index prefix, const int c){
+    assert(a != NULL);
+    assert(idx >= INDEX_FIRST && idx < a->current_num);
+    assert(prefix != idx && array_has_this_codeword(a, prefix));
 
-    a->nodes[a->current_num] = (char*) malloc ((strlen(k)+1)*sizeof(char));
-    assert(a->nodes[a->current_num] != NULL);
+    a->prefix[idx] = prefix;
+    a->suffix[idx] = c;
 
-    strcpy(a->nodes[a->current_num], k);
-    a->current_num += 1;    // update the counter
-    return a->current_num - 1;
+    if (prefix <= 255){
+        a->first[idx] = prefix;
+        a->length[idx] = 1;
+    }
+    else{
+        a->first[idx] = a->first[prefix];
+        a->length[idx] = a->length[prefix] + 1;
+    }
+
+    return;
 }
 
 
@@ -373,7 +703,7 @@ bool array_has_this_codeword(Array a, const Index idx){
         return true;
     }
     else{
-        return a->nodes[idx] != NULL;
+        return idx >= INDEX_FIRST && idx < a->current_num;
     }
 }
 
@@ -385,15 +715,229 @@ void array_print(const Array a){
     fprintf(stdout, "-----Array print-----\n");
     fprintf(stdout, "Size = %d, current_num = %ld\n", SIZE_LIMIT, a->current_num);
 
-    for (Index i = 0; i < SIZE_LIMIT; i++){
+    for (Index i = 0; i < a->current_num; i++){
         if (i <= 255){
             fprintf(stdout, "%ld => %c\n", i, (int) i);
         }
-        else if (a->nodes[i] != NULL){
-            fprintf(stdout, "%ld => %s\n", i, a->nodes[i]);
+        else if (i >= INDEX_FIRST){
+            fprintf(stdout, "%ld => %d + %c\n", i, a->prefix[i], a->suffix[i]);
         }
     }
 
     fprintf(stdout, "-----End-----\n");
+    return;
+}
+
+
+// recency list, all arrays are indexed by codeword
+Recency recency_create(void){
+    Recency r = (Recency) malloc(sizeof(struct _Recency));
+    assert(r != NULL);
+
+    r->prefix = (int*) malloc(SIZE_LIMIT * sizeof(int));
+    r->children = (int*) malloc(SIZE_LIMIT * sizeof(int));
+    r->prev = (int*) malloc(SIZE_LIMIT * sizeof(int));
+    r->next = (int*) malloc(SIZE_LIMIT * sizeof(int));
+    assert(r->prefix != NULL && r->children != NULL);
+    assert(r->prev != NULL && r->next != NULL);
+
+    recency_reset(r);
+    return r;
+}
+
+
+Recency recency_destroy(Recency r){
+    assert(r != NULL);
+
+    free(r->prefix);
+    free(r->children);
+    free(r->prev);
+    free(r->next);
+    free(r);
+    r = NULL;
+    return r;
+}
+
+
+// only the counters of the single chars need to be cleared,
+// the others are set when the entry is added
+void recency_reset(Recency r){
+    assert(r != NULL);
+
+    for (Index i = 0; i < INDEX_FIRST; i++){
+        r->children[i] = 0;
+    }
+
+    r->head = -1;
+    r->tail = -1;
+    return;
+}
+
+
+// append to the newest end of the list
+void recency_append(Recency r, const Index cw){
+    r->prev[cw] = r->tail;
+    r->next[cw] = -1;
+
+    if (r->tail == -1){
+        r->head = cw;
+    }
+    else{
+        r->next[r->tail] = cw;
+    }
+
+    r->tail = cw;
+    return;
+}
+
+
+// remove from the list
+void recency_unlink(Recency r, const Index cw){
+    if (r->prev[cw] == -1){
+        r->head = r->next[cw];
+    }
+    else{
+        r->next[r->prev[cw]] = r->next[cw];
+    }
+
+    if (r->next[cw] == -1){
+        r->tail = r->prev[cw];
+    }
+    else{
+        r->prev[r->next[cw]] = r->prev[cw];
+    }
+
+    return;
+}
+
+
+// the prefix gets one more child, it is no longer a leaf
+void recency_add_child(Recency r, const Index prefix){
+    if (prefix >= INDEX_FIRST && r->children[prefix] == 0){
+        recency_unlink(r, prefix);
+    }
+    r->children[prefix] += 1;
+    return;
+}
+
+
+void recency_add(Recency r, const Index cw, const Index prefix){
+    assert(r != NULL);
+    assert(cw >= INDEX_FIRST && cw < SIZE_LIMIT);
+    assert(prefix >= 0 && prefix < SIZE_LIMIT);
+
+    recency_add_child(r, prefix);
+
+    r->prefix[cw] = prefix;
+    r->children[cw] = 0;
+    recency_append(r, cw);
+    return;
+}
+
+
+Index recency_replace(Recency r, const Index prefix){
+    assert(r != NULL);
+    assert(prefix >= 0 && prefix < SIZE_LIMIT);
+
+    // the prefix itself can not be replaced, 
+    // and if it is the only leaf, nothing can be replaced
+    if (r->head == -1 || (r->head == prefix && r->next[prefix] == -1)){
+        return -1;
+    }
+
+    recency_add_child(r, prefix);
+
+    // the oldest leaf is removed from its own prefix
+    Index victim = r->head;
+    recency_unlink(r, victim);
+
+    Index old_prefix = r->prefix[victim];
+    r->children[old_prefix] -= 1;
+    if (old_prefix >= INDEX_FIRST && r->children[old_prefix] == 0){
+        recency_append(r, old_prefix);
+    }
+
+    // and becomes the new entry
+    r->prefix[victim] = prefix;
+    r->children[victim] = 0;
+    recency_append(r, victim);
+
+    return victim;
+}
+
+
+// seed, the entries are filled by the caller
+Seed seed_create(const int id, const long count){
+    assert(id >= 1 && id <= 255);
+    assert(count >= 0 && count <= SEED_MAX);
+
+    Seed s = (Seed) malloc(sizeof(struct _Seed));
+    assert(s != NULL);
+
+    s->id = id;
+    s->count = count;
+    s->prefix = (Code*) malloc((count + 1) * sizeof(Code));
+    s->suffix = (unsigned char*) malloc((count + 1) * sizeof(unsigned char));
+    assert(s->prefix != NULL && s->suffix != NULL);
+
+    return s;
+}
+
+
+Seed seed_destroy(Seed s){
+    assert(s != NULL);
+
+    free(s->prefix);
+    free(s->suffix);
+    free(s);
+    s = NULL;
+    return s;
+}
+
+
+// segment index, start with a small list and double the size when full
+SegmentIndex segment_index_create(void){
+    SegmentIndex idx = (SegmentIndex) malloc(sizeof(struct _SegmentIndex));
+    assert(idx != NULL);
+
+    idx->count = 0;
+    idx->size = 64;
+
+    idx->bit_offsets = (long*) malloc(idx->size * sizeof(long));
+    idx->input_offsets = (long*) malloc(idx->size * sizeof(long));
+    assert(idx->bit_offsets != NULL && idx->input_offsets != NULL);
+
+    return idx;
+}
+
+
+SegmentIndex segment_index_destroy(SegmentIndex idx){
+    assert(idx != NULL);
+
+    free(idx->bit_offsets);
+    free(idx->input_offsets);
+    free(idx);
+    idx = NULL;
+    return idx;
+}
+
+
+void segment_index_insert(SegmentIndex idx, long bit_offset, long input_offset){
+    assert(idx != NULL);
+    assert(bit_offset >= 0 && input_offset >= 0);
+    assert(idx->count == 0 || (bit_offset >= idx->bit_offsets[idx->count-1] 
+                && input_offset >= idx->input_offsets[idx->count-1]));
+
+    if (idx->count == idx->size){
+        idx->size *= 2;
+        idx->bit_offsets = (long*) realloc(idx->bit_offsets, idx->size * sizeof(long));
+        idx->input_offsets = (long*) realloc(idx->input_offsets, idx->size * sizeof(long));
+        assert(idx->bit_offsets != NULL && idx->input_offsets != NULL);
+    }
+
+    idx->bit_offsets[idx->count] = bit_offset;
+    idx->input_offsets[idx->count] = input_offset;
+    idx->count += 1;
+
     return;
 }
\ No newline at end of file
@@ -16,86 +16,236 @@ however it also fails to reflect more local characteristics.
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include <math.h>
+#include <stdint.h>
 
 
 // define the fundamental amounts
 #define BITS 14                         // length for the codeword
-#define SIZE_LIMIT (int) pow(2, BITS)   // array size
-#define CAPACITY_FACTOR 2               // dictionary size = array size * factor, 
+#define SIZE_LIMIT (1 << BITS)          // array size
+#define CAPACITY_BITS (BITS + 1)        // dictionary size = 2 ^ CAPACITY_BITS = array size * 2, 
                                         //      larger size to reduce hash collision
 
+// codewords are kept in 16 bits in the tables
+#if BITS > 16
+#error "BITS must be at most 16"
+#endif
+
+// the tables are allocated for BITS, but can be used with shorter 
+// codewords, down to MIN_BITS, chosen at run time
+#define MIN_BITS 9
+
 
 // hash dictionary component
 typedef long Index;          // for 12 bits, max = 4096
 typedef long CodeWord;       // for 12 bits, max  = 4096
-typedef char* Key;          // key is a string
+typedef uint16_t Code;       // a codeword as stored in the tables
+typedef uint16_t Generation; // bumped at each reset, 
+                             // slots with an older stamp are empty
+#define SEED_STAMP 0xFFFF    // stamp of a seed entry, live in every generation
 
 
 // reserve 256 for EOF, and 257 for reflush dictionary
 #define INDEX_EOF 256
 #define INDEX_REFLUSH 257
+#define INDEX_FIRST 258      // first codeword for a string of 2 chars or more
 
 
-//-----------hash dictionary functions------------
-// hash dictionary node and format
-struct _Node{
-    Key k;
-    CodeWord cw;
-    struct _Node* next;
+// what to do when the dictionary is full
+#define RESET_FULL 0        // reflush straight away
+#define RESET_RATIO 1       // keep using it, reflush when the ratio gets worse
+#define RESET_LRU 2         // replace the least recently used leaf entry
+
+
+// how the dictionary grows after each phrase (match) M is printed
+#define GROWTH_LZW 0        // previous phrase + first char of M
+#define GROWTH_LZMW 1       // previous phrase + M
+#define GROWTH_LZAP 2       // previous phrase + every prefix of M
+
+
+// GROWTH_LZMW walks to a new phrase one char at a time, through entries
+// which are not phrases. these trie nodes have their own numbers, so only
+// the phrases take codewords, and there are more nodes than codewords.
+// a node is kept in a Code too, so at most 16 bits
+#define NODE_BITS (BITS + 2 < 16 ? BITS + 2 : 16)
+#define NODE_LIMIT (1 << NODE_BITS)
+
+
+//-----------seed dictionary------------
+// entries that every dictionary and array starts with, again after each
+// reset, so that a small file does not have to learn everything first.
+// entry i is codeword INDEX_FIRST + i, its prefix is a char or an earlier 
+// entry. built from sample files by the train program
+#define SEED_MAX (SIZE_LIMIT / 2)   // leave room for the file's own entries
+
+struct _Seed{
+    int id;                 // 1 - 255, kept in the header of the compressed file
+    long count;
+    Code* prefix;
+    unsigned char* suffix;
+};
+typedef struct _Seed* Seed;
+
+// create with room for count entries, destroy
+Seed seed_create(const int id, const long count);
+Seed seed_destroy(Seed);
+
+
+//-----------least recently used leaves------------
+// only used by the RESET_LRU policy, both in compression and decompression.
+// an entry is a leaf if no other entry uses it as prefix, 
+// replacing a leaf never breaks another entry.
+// a leaf only becomes "used" when it is printed, and a printed entry 
+// always gets a child straight away, so the leaves are kept in 
+// the order they were created (or became a leaf again), oldest first
+struct _Recency{
+    int* prefix;            // prefix codeword of each entry
+    int* children;          // number of entries with this prefix
+    int* prev;              // doubly linked list of the leaves
+    int* next;
+    int head;               // oldest leaf, -1 if empty
+    int tail;               // newest leaf
 };
-typedef struct _Node* Node;
+typedef struct _Recency* Recency;
 
+// create
+Recency recency_create(void);
+// destroy
+Recency recency_destroy(Recency);
+// reset, forget all entries
+void recency_reset(Recency);
+// a new entry cw = prefix + char
+void recency_add(Recency, const Index cw, const Index prefix);
+// replace the oldest leaf by a new entry with this prefix, 
+// return the codeword reused, -1 if no leaf can be replaced
+Index recency_replace(Recency, const Index prefix);
+
+
+//-----------hash dictionary functions------------
+// every entry is its prefix codeword + one char, stored in parallel arrays 
+// indexed by codeword, so no string is ever built or compared.
+// the hash table is open addressing with linear probing, each slot only 
+// keeps a codeword, and a stamp telling if the slot is from this generation.
+// most searches are for 2 chars, an entry with a single char prefix is 
+// not hashed but kept in a 256 x 256 table, indexed by prefix and char.
+// for 14 bits: 48KB of entries + 128KB of slots + 256KB of root table
+// an entry is a node of the trie, its number is its codeword, except for
+// GROWTH_LZMW where code and node map one to the other
 struct _Dictionary{
     Index current_num;
-    Node* nodes;
+    Index limit;            // 1 << bits, full when current_num reaches it
+    int bits;               // codeword length, BITS unless set
+    Index node_num;         // the same as current_num, but for GROWTH_LZMW
+    Index node_limit;       // SIZE_LIMIT, or NODE_LIMIT for GROWTH_LZMW
+    int capacity_bits;      // hash table of 2 ^ capacity_bits slots, 2 per node
+    Code* prefix;           // prefix codeword of each entry
+    unsigned char* suffix;  // last char of each entry
+    Code* slots;            // hash table, codeword of the entry in the slot
+    Generation* stamps;     // generation of each slot
+    Code* root;             // 256 * 256, codeword of the entry char + char
+    Generation* root_stamps;    // generation of each root entry
+    Generation generation;
+    int policy;
+    int growth;
+    Recency recency;        // only for RESET_LRU
+    Code* code;             // GROWTH_LZMW only, codeword of each node, 0 for a node
+                            //      only needed on the way to a longer one
+    Code* node;             // GROWTH_LZMW only, node of each codeword
+    unsigned char* buffer;  // node_limit bytes, for dictionary_string
+    Seed seed;              // loaded after each reset, NULL for none
+    bool seed_loaded;       // the seed entries are still there, except RESET_LRU
+                            //      they are never removed, and not loaded again
 };
 typedef struct _Dictionary* Dictionary;
 
 
 // hash function
-// input the string and calculate the hash
-Index calculate_index(const char*);
+// input the entry (prefix + char) and calculate the slot, of "bits" bits
+Index calculate_index(const CodeWord prefix, const int c, const int bits);
 
-// create
-Dictionary dictionary_create(void);
+// create, the policy and the growth are kept after each reset
+Dictionary dictionary_create(const int policy, const int growth);
 // destroy
 Dictionary dictionary_destroy(Dictionary);
-// reset,  = destroy + create
+// reset, O(1): only the generation changes
+// returns the same dictionary
 Dictionary dictionary_reset(Dictionary);
 // check if is full, if full, need reset
 bool dictionary_is_full(const Dictionary);
+// start from the seed entries, now and after each reset
+// the seed is owned by the caller
+void dictionary_set_seed(Dictionary, const Seed);
+// use codewords of "bits" bits, MIN_BITS to BITS, before any seed is set
+void dictionary_set_bits(Dictionary, const int bits);
+
+// check if the string of prefix + c exist, prefix = -1 for the single char c
+// if exist return the codeword, if not return -1 
+// for GROWTH_LZMW, prefix and the result are nodes, see dictionary_code
+CodeWord dictionary_search(Dictionary, const CodeWord prefix, const int c);
+// insert prefix + c, which must not exist yet
+// if the dictionary is full, only RESET_LRU can insert by replacing 
+// an old entry, otherwise return -1
+// for GROWTH_LZMW, the new entry is a node without codeword
+CodeWord dictionary_insert(Dictionary, const CodeWord prefix, const int c);
 
-// check if the key exist, 
-// if exist return the index, if not return -1 
-CodeWord dictionary_search(Dictionary, const Key k);
-// insert
-CodeWord dictionary_insert(Dictionary, const Key k);
+// the codeword of a node, -1 if it is not a phrase, only GROWTH_LZMW 
+// has such nodes, the other dictionaries return the node itself
+CodeWord dictionary_code(const Dictionary, const CodeWord node);
+// the string of a codeword, the pointer is inside the dictionary and is 
+// only valid until the next call. length is set to the string length
+unsigned char* dictionary_string(Dictionary, const CodeWord cw, long* length);
+// GROWTH_LZMW and GROWTH_LZAP, add the entries for the phrase cw 
+// printed after the phrase prev, nothing if prev = -1.
+// the encoder and the decoder do the same, so the codewords match.
+// stop if the dictionary is full
+void dictionary_grow(Dictionary, const CodeWord prev, const CodeWord cw);
 
 // debug use
 void dictionary_print(Dictionary);
 
 
 // ------------Array definition----------------
+// the same parallel arrays as the dictionary, the string of a codeword
+// is rebuilt backwards by following the prefixes.
+// the first char and the length are kept so that no walk is needed for them
 struct _Array{
     Index current_num;
-    char** nodes;
+    Index limit;            // the same as the dictionary
+    int bits;
+    Code* prefix;
+    unsigned char* suffix;
+    unsigned char* first;   // first char of the string
+    Code* length;           // length of the string - 1
+    unsigned char* buffer;  // SIZE_LIMIT bytes, the string is rebuilt here
+    int policy;
+    Recency recency;        // only for RESET_LRU
+    Seed seed;              // loaded after each reset, NULL for none
+    bool seed_loaded;       // the same as the dictionary
 };
 typedef struct _Array* Array;
 
-// create
-Array array_create(void);
+// create, the policy is kept after each reset
+Array array_create(const int policy);
 // delete 
 Array array_destroy(Array);
-// reset = destroy + create
+// reset, O(1): only the counter goes back
+// returns the same array
 Array array_reset(Array);
 // check if full
 bool array_is_full(const Array);
+// the same as dictionary_set_seed and dictionary_set_bits
+void array_set_seed(Array, const Seed);
+void array_set_bits(Array, const int bits);
 
-// search using index, return the string
-Key array_search(Array, const Index);
-// insert
-Index array_insert(Array, const Key k);
+// the string of a codeword, the pointer is inside the array and is
+// only valid until the next call. length is set to the string length
+unsigned char* array_search(Array, const Index, long* length);
+// first char of the string of a codeword
+int array_first_char(Array, const Index);
+// the index the next entry will take, its prefix is needed by RESET_LRU
+// return -1 if the array is full and the entry will not be added
+Index array_reserve(Array, const Index prefix);
+// set a reserved index to the string of prefix + c
+void array_set(Array, const Index, const Index prefix, const int c);
 // check if a codeword is in the table
 bool array_has_this_codeword(Array, const Index);
 
@@ -103,4 +253,24 @@ bool array_has_this_codeword(Array, const Index);
 void array_print(const Array);
 
 
+// ------------Segment index----------------
+// every reflush fully resets the decoder, so the stream after a reflush
+// can be decoded on its own. The index records where each such segment
+// starts, both in the compressed bits and in the original file.
+struct _SegmentIndex{
+    long count;
+    long size;
+    long* bit_offsets;
+    long* input_offsets;
+};
+typedef struct _SegmentIndex* SegmentIndex;
+
+// create
+SegmentIndex segment_index_create(void);
+// destroy
+SegmentIndex segment_index_destroy(SegmentIndex);
+// append a segment start, offsets must not decrease
+void segment_index_insert(SegmentIndex, long bit_offset, long input_offset);
+
+
 #endif 
\ No newline at end of file
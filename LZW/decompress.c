@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
 #include "util.h"
 #include "data_structure.h"
 #include "file.h"
@@ -11,58 +12,130 @@
 
 int main(int argc, char** argv){
 
-    // first check the input number
-    if (argc != 2){
-        fprintf(stderr, "Usage: %s <filename>\n", argv[0]);
-        exit(EXIT_FAILURE);
+    // first check the input, optional number of threads,
+    // the seed dictionary the file was compressed with, and the output name
+    int threads = 1;
+    char* seed_file = NULL;
+    char* file_out = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:D:o:")) != -1){
+        if (opt == 'j'){
+            threads = atoi(optarg);
+        }
+        else if (opt == 'o'){
+            file_out = optarg;
+        }
+        else if (opt == 'D'){
+            seed_file = optarg;
+        }
+        else{
+            threads = 0;
+        }
     }
 
-    // check the input file name with .LZW at the end
-    if (! check_input_file(argv[1])){
-        fprintf(stderr, "Usage: %s <filename.LZW>\n", argv[0]);
+    if (optind != argc - 1 || threads < 1){
+        fprintf(stderr, "Usage: %s [-j threads] [-D seed] [-o output] <filename.LZW | ->\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    // first create the new name for decompressed file, prefix = deLZW_
-    char* file_in = argv[1];
-    char* file_out = create_decompressed_file_name(file_in);
+    // without -o: stdin goes to stdout, and a file needs .LZW at the end
+    char* file_in = argv[optind];
+    char* name_created = NULL;
+
+    if (file_out == NULL && strcmp(file_in, STREAM_NAME) == 0){
+        file_out = STREAM_NAME;
+    }
+    else if (file_out == NULL){
+        if (! check_input_file(file_in)){
+            fprintf(stderr, "Usage: %s [-j threads] [-D seed] [-o output] <filename.LZW | ->\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+
+        // create the new name for decompressed file, prefix = deLZW_
+        name_created = create_decompressed_file_name(file_in);
+        file_out = name_created;
+    }
 
-    // create the file descriptor
+    // create the file descriptor, the output only once the header is checked
     FILE* fp_in = open_file_for_read(file_in);
+
+    // the header is optional, the default policy and coder are used without it
+    // the bit reader keeps the bits not yet read
+    Header h = header_create();
+    BitReader br = bit_reader_create(fp_in);
+    if (! header_read(br, h)){
+        fprintf(stderr, "%s is not a valid .LZW file\n", file_in);
+        exit(EXIT_FAILURE);
+    }
+
+    // the decoder must start from the same seed as the compressor
+    if (h->dict_id != 0){
+        if (seed_file == NULL){
+            fprintf(stderr, "%s needs the seed dictionary %d, use -D\n", file_in, h->dict_id);
+            exit(EXIT_FAILURE);
+        }
+
+        h->seed = seed_read(seed_file);
+        if (h->seed->id != h->dict_id){
+            fprintf(stderr, "%s needs the seed dictionary %d, %s is %d\n", 
+                    file_in, h->dict_id, seed_file, h->seed->id);
+            exit(EXIT_FAILURE);
+        }
+    }
+
     FILE* fp_out = open_file_for_write(file_out);
 
-    // create the array
-    Array a = array_create();
-    
-    // decompression
-    int buffer = fgetc(fp_in); 
-    int buffer_bits_not_read = 8;
-    // return false if meet reflush, true if meet eof
-    bool finish = decompression_cycle(
-        &buffer, &buffer_bits_not_read,
-        a, fp_in, fp_out
-    );
-
-    // continue the decompression until meet eof
-    while (! finish){
-        // meet reflush sign, refresh array
-        a = array_reset(a);
-        finish = decompression_cycle(
-            &buffer, &buffer_bits_not_read,
-            a, fp_in, fp_out
-        );
+    // with a segment index, the segments can be decoded at the same time
+    // the index is at the end and the output is written out of order, 
+    // so both must be regular files, a pipe is always decoded in one go
+    long input_size = 0;
+    SegmentIndex index = NULL;
+    if (threads > 1 && file_is_regular(fp_in) && file_is_regular(fp_out)){
+        index = read_index_from_file(fp_in, &input_size);
+    }
+
+    // false if the file is truncated or damaged
+    bool valid;
+    if (index != NULL){
+        valid = decompress_parallel(file_in, fp_out, index, input_size, threads, h);
+        segment_index_destroy(index);
+    }
+    else{
+        // the strings go through the buffer of a byte writer
+        BitWriter out = bit_writer_create(fp_out);
+        valid = decompress_serial(br, h, out);
+        bit_writer_destroy(out);
+    }
+
+    bit_reader_destroy(br);
+    if (h->seed != NULL){
+        seed_destroy(h->seed);
     }
+    header_destroy(h);
 
     // finish, close the file
     fclose(fp_in);
     fclose(fp_out);
 
-    // output the status
-    decompress_status(file_in, file_out);
+    // do not leave a partly decoded file behind
+    if (! valid){
+        fprintf(stderr, "%s is not a valid .LZW file\n", file_in);
+        if (strcmp(file_out, STREAM_NAME) != 0){
+            remove(file_out);
+        }
+        exit(EXIT_FAILURE);
+    }
+
+    // output the status, unless the output itself goes to stdout
+    if (strcmp(file_out, STREAM_NAME) != 0){
+        decompress_status(file_in, file_out);
+    }
 
     // free the memory
-    array_destroy(a);
-    free(file_out);
+    if (name_created != NULL){
+        free(name_created);
+    }
 
     return 0;
 }
@@ -3,12 +3,35 @@
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "util.h"
 #include "data_structure.h"
 #include "file.h"
 #include "decompress_func.h"
 
 
+// shared by all threads of the parallel decompression
+// each thread takes the next segment not yet decoded
+struct _Worker{
+    const char* file_in;
+    SegmentIndex index;
+    long input_size;
+    Header h;
+    int fd_out;
+    long next;
+    bool failed;            // a segment is not valid, the others are not needed
+    pthread_mutex_t lock;
+};
+typedef struct _Worker* Worker;
+
+// thread function, decode segments until none is left
+void* decompress_segments(void* arg);
+
+// read a number of "bytes" bytes, msb first
+long read_number_from_file(FILE* fp, int bytes);
+
+
 // check if the input file has .LZW at the end
 bool check_input_file(const char* filename){
    // second check if the file has .LZW as the end
@@ -37,71 +60,73 @@ char* create_decompressed_file_name(const char* file_in){
 }
 
 
+// read one codeword, the bit reader does the refill
+// the 0 bits after the end of file are never taken as a codeword
+CodeWord read_from_file(BitReader br, HuffmanReader hr, const int bits){
+    assert(br != NULL);
+
+    CodeWord cw;
+    if (hr != NULL){
+        cw = huffman_reader_get(hr);
+    }
+    else{
+        cw = (CodeWord) bit_reader_get(br, bits);
+    }
+
+    if (bit_reader_is_past_end(br)){
+        return -1;
+    }
+    return cw;
+}
+
+
 // each cycle stops when meet reflush or pesudo eof
-bool decompression_cycle(int* buffer, int* buffer_bits_not_read,
-                            Array a, FILE* fp_in, FILE* fp_out){
-    // each cycle ends whether meet reflush, or eof
-    // if reflush, return false
-    // if eof, return true
-    bool flag = false;
+int decompression_cycle(BitReader br, HuffmanReader hr, Array a, BitWriter out){
+    // each cycle ends whether meet reflush, or eof, 
+    // or a codeword that can not be decoded
+    int status = CYCLE_REFLUSH;
     
-    int mask;
-    CodeWord cw = 0;
-    int cw_bits = 0;
-
     // read in a code, normally around 12 bits
-    while (cw_bits != BITS){
-        // read buffer if necessary
-        if (*buffer_bits_not_read == 0){
-            *buffer = fgetc(fp_in);
-            *buffer_bits_not_read = 8;
-        }
+    CodeWord cw = read_from_file(br, hr, a->bits);
+
+    // the parallel compressor pads each segment to a whole byte with
+    // extra reflush codes, so a cycle can start with reflush, or even eof
+    while (cw == INDEX_REFLUSH){
+        cw = read_from_file(br, hr, a->bits);
+    }
 
-        mask = 1 << (*buffer_bits_not_read - 1);
-        
-        cw <<= 1;
-        cw |= ((*buffer & mask) >> (*buffer_bits_not_read - 1));
+    if (cw == INDEX_EOF){
+        return CYCLE_EOF;
+    }
 
-        cw_bits += 1;
-        *buffer_bits_not_read -= 1;
+    // the first codeword of a cycle is a char or a seed entry
+    if (cw < 0 || ! array_has_this_codeword(a, cw)){
+        return CYCLE_ERROR;
     }
 
     // main part for decompression
     // define the variables
-    char *prev_key, *curr_key;
-    prev_key = NULL; curr_key = NULL;
-
-    // assign prev_key, this is the first bit
-    prev_key = array_search(a, cw);
-    // output the first byte
-    fputs(prev_key, fp_out);
+    CodeWord prev_cw = cw;
+    Index idx;
+    int c;
+    long length;
+    unsigned char* key;
+
+    // output the first string, this is the first bit
+    key = array_search(a, cw, &length);
+    if (! bit_writer_has_room(out, length)){
+        return CYCLE_ERROR;
+    }
+    bit_writer_put_bytes(out, key, length);
 
     // while we have not reach the index eof = 256
     while (true){
-        // every time, clear the code first
-        cw = 0;
-        cw_bits = 0;
-
         // read in a code, store in cw
-        while (cw_bits != BITS){
-            // read buffer if necessary
-            if (*buffer_bits_not_read == 0){
-                *buffer = fgetc(fp_in);
-                *buffer_bits_not_read = 8;
-            }
-
-            mask = 1 << (*buffer_bits_not_read - 1);
-
-            cw <<= 1;
-            cw |= ((*buffer & mask) >> (*buffer_bits_not_read - 1));
-
-            cw_bits += 1;
-            *buffer_bits_not_read -= 1;
-        }
+        cw = read_from_file(br, hr, a->bits);
 
         // if code = 256, eof
         if (cw == INDEX_EOF){
-            flag = true;
+            status = CYCLE_EOF;
             break;
         }
 
@@ -110,57 +135,339 @@ bool decompression_cycle(int* buffer, int* buffer_bits_not_read,
             break;
         }
 
-        // if cw is in the table
-        if (array_has_this_codeword(a, cw)){
-            // output string(cw)
-            curr_key = array_search(a, cw);
-            fputs(curr_key, fp_out);
+        // past the end of file
+        if (cw < 0){
+            status = CYCLE_ERROR;
+            break;
+        }
 
-            // string(prev) + first char of string(cw)
-            prev_key = (char*)realloc(prev_key, strlen(prev_key)+1+1);
-            assert(prev_key != NULL);
-            strncat(prev_key, curr_key, 1);
+        // the compressor added string(prev) + c right after printing prev,
+        // find out where it went, -1 if the table was full and it was not added
+        idx = array_reserve(a, prev_cw);
 
-            // insert into table
-            array_insert(a, prev_key);
+        if (cw != idx){
+            // cw is in the table, c is the first char of string(cw)
+            if (! array_has_this_codeword(a, cw)){
+                status = CYCLE_ERROR;
+                break;
+            }
+            c = array_first_char(a, cw);
         }
         else{
             // special case for codeword created and used immediately
-            // with no time gap
-            // so that this codeword has not been inserted yet
+            // with no time gap, string(cw) = string(prev) + first char of prev
+            c = array_first_char(a, prev_cw);
+        }
+
+        // string(prev) + c, insert into table
+        // only a leaf is replaced, so string(cw) is not changed by this
+        if (idx != -1){
+            array_set(a, idx, prev_cw, c);
+        }
+
+        // output string(cw)
+        key = array_search(a, cw, &length);
+        if (! bit_writer_has_room(out, length)){
+            status = CYCLE_ERROR;
+            break;
+        }
+        bit_writer_put_bytes(out, key, length);
+
+        prev_cw = cw;
+    }
+
+    return status;
+}
+
+
+int decompression_cycle_grow(BitReader br, HuffmanReader hr, Dictionary d, BitWriter out){
+    // same as decompression_cycle, but the table is a dictionary
+    // that grows by a whole phrase after each codeword
+    CodeWord cw = read_from_file(br, hr, d->bits);
+
+    while (cw == INDEX_REFLUSH){
+        cw = read_from_file(br, hr, d->bits);
+    }
+
+    if (cw == INDEX_EOF){
+        return CYCLE_EOF;
+    }
+
+    CodeWord prev_cw = -1;
+    long length;
+    unsigned char* key;
+
+    while (true){
+        // the compressor grows the dictionary only after printing cw, 
+        // so cw is always known here, no special case as in LZW
+        if (cw < 0 || cw >= d->current_num){
+            return CYCLE_ERROR;
+        }
+        key = dictionary_string(d, cw, &length);
+        if (! bit_writer_has_room(out, length)){
+            return CYCLE_ERROR;
+        }
+        bit_writer_put_bytes(out, key, length);
+
+        // string(prev) + string(cw), or + a prefix of it when full
+        dictionary_grow(d, prev_cw, cw);
+        prev_cw = cw;
+
+        cw = read_from_file(br, hr, d->bits);
+
+        if (cw == INDEX_EOF){
+            return CYCLE_EOF;
+        }
+
+        if (cw == INDEX_REFLUSH){
+            return CYCLE_REFLUSH;
+        }
+    }
+}
+
+
+// the serial decoder, one table reset after each reflush until eof
+bool decompress_serial(BitReader br, const Header h, BitWriter out){
+    assert(br != NULL && h != NULL && out != NULL);
+
+    if (h->growth != GROWTH_LZW){
+        // LZMW / LZAP, the decoder needs the same dictionary as the compressor
+        Dictionary d = dictionary_create(h->policy, h->growth);
+        dictionary_set_seed(d, h->seed);
+
+        HuffmanReader hr = NULL;
+        if (h->coder == CODER_HUFFMAN){
+            hr = huffman_reader_create(br);
+        }
+
+        int status = decompression_cycle_grow(br, hr, d, out);
+        while (status == CYCLE_REFLUSH){
+            d = dictionary_reset(d);
+            status = decompression_cycle_grow(br, hr, d, out);
+        }
+
+        dictionary_destroy(d);
+        if (hr != NULL){
+            huffman_reader_destroy(hr);
+        }
+        return status == CYCLE_EOF;
+    }
+
+    // create the array
+    Array a = array_create(h->policy);
+    array_set_seed(a, h->seed);
+
+    // LZW-H, the codewords are read through the huffman blocks
+    HuffmanReader hr = NULL;
+    if (h->coder == CODER_HUFFMAN){
+        hr = huffman_reader_create(br);
+    }
+    
+    // decompression
+    int status = decompression_cycle(br, hr, a, out);
+
+    // continue the decompression until meet eof, or an error
+    while (status == CYCLE_REFLUSH){
+        // meet reflush sign, refresh array
+        a = array_reset(a);
+        status = decompression_cycle(br, hr, a, out);
+    }
+
+    array_destroy(a);
+    if (hr != NULL){
+        huffman_reader_destroy(hr);
+    }
+
+    return status == CYCLE_EOF;
+}
+
+
+long read_number_from_file(FILE* fp, int bytes){
+    long result = 0;
+    for (int i = 0; i < bytes; i++){
+        result = (result << 8) | (getc(fp) & 0xFF);
+    }
+    return result;
+}
+
 
-            // prev_key + first char of prev_key
-            // insert it into the table
-            // and output it
-            curr_key = (char*)malloc((strlen(prev_key)+1+1)*sizeof(char));
-            assert(curr_key != NULL);
+// trailer: (bit offset, input offset) * count, input size, count, "LZWI"
+SegmentIndex read_index_from_file(FILE* fp, long* input_size){
+    assert(fp != NULL && input_size != NULL);
 
-            // copy prev_key, and then concat the first char of the prev_key
-            strcpy(curr_key, prev_key);
-            strncat(curr_key, prev_key, 1);
+    // the bit reader may already have read ahead, come back to the same place
+    long pos = ftell(fp);
+    long file_len = file_size(fp);
+    if (file_len < 16){
+        fseek(fp, pos, SEEK_SET);
+        return NULL;
+    }
+
+    // check the magic at the end
+    char magic[4];
+    fseek(fp, file_len - 4, SEEK_SET);
+    if (fread(magic, 1, 4, fp) != 4 || strncmp(magic, "LZWI", 4) != 0){
+        fseek(fp, pos, SEEK_SET);
+        return NULL;
+    }
+
+    fseek(fp, file_len - 16, SEEK_SET);
+    *input_size = read_number_from_file(fp, 8);
+    long count = read_number_from_file(fp, 4);
+
+    if (count <= 0 || 16 * count > file_len - 16){
+        fseek(fp, pos, SEEK_SET);
+        return NULL;
+    }
+
+    SegmentIndex index = segment_index_create();
+    fseek(fp, file_len - 16 - 16 * count, SEEK_SET);
+
+    for (long i = 0; i < count; i++){
+        long bit_offset = read_number_from_file(fp, 8);
+        long input_offset = read_number_from_file(fp, 8);
+        segment_index_insert(index, bit_offset, input_offset);
+    }
 
-            // insert into array
-            array_insert(a, curr_key);
-            
-            // also print it out
-            fputs(curr_key, fp_out);
+    fseek(fp, pos, SEEK_SET);
+    return index;
+}
+
+
+// each thread has its own file pointer, bit reader and array
+// the output of a segment is collected in memory, then pwrite
+void* decompress_segments(void* arg){
+    Worker w = (Worker) arg;
+    assert(w != NULL);
+
+    FILE* fp_in = open_file_for_read(w->file_in);
+    BitReader br = bit_reader_create(fp_in);
+    Array a = NULL;
+    Dictionary d = NULL;
+    if (w->h->growth == GROWTH_LZW){
+        a = array_create(w->h->policy);
+        array_set_seed(a, w->h->seed);
+    }
+    else{
+        d = dictionary_create(w->h->policy, w->h->growth);
+        dictionary_set_seed(d, w->h->seed);
+    }
+
+    HuffmanReader hr = NULL;
+    if (w->h->coder == CODER_HUFFMAN){
+        hr = huffman_reader_create(br);
+    }
+
+    long i;
+    long length;
+    int status;
+    bool failed;
+    BitWriter out;
+
+    while (true){
+        pthread_mutex_lock(&w->lock);
+        i = w->next;
+        w->next += 1;
+        failed = w->failed;
+        pthread_mutex_unlock(&w->lock);
+
+        if (i >= w->index->count || failed){
+            break;
+        }
+
+        // a reflush right before eof or at the end of a segment gives an empty one
+        if (i + 1 < w->index->count){
+            length = w->index->input_offsets[i+1] - w->index->input_offsets[i];
+        }
+        else{
+            length = w->input_size - w->index->input_offsets[i];
+        }
+
+        if (length == 0){
+            continue;
+        }
+
+        // decode until the reflush (or eof) at the end of this segment
+        // a wrong index can not make it write more than the segment
+        out = bit_writer_create(NULL);
+        bit_writer_set_limit(out, length);
+
+        bit_reader_seek(br, w->index->bit_offsets[i]);
+        if (hr != NULL){
+            huffman_reader_reset(hr);
+        }
+        if (d != NULL){
+            d = dictionary_reset(d);
+            status = decompression_cycle_grow(br, hr, d, out);
+        }
+        else{
+            a = array_reset(a);
+            status = decompression_cycle(br, hr, a, out);
         }
 
-        // prev_key = curr_key
-        free(prev_key);
-        prev_key = NULL;
-        prev_key = (char*)malloc((strlen(curr_key)+1)*sizeof(char));
-        assert(prev_key != NULL);
-        strcpy(prev_key, curr_key);
+        // the index does not match the segment, or the segment can not be decoded
+        if (status == CYCLE_ERROR || out->buffer_len != length){
+            pthread_mutex_lock(&w->lock);
+            w->failed = true;
+            pthread_mutex_unlock(&w->lock);
+            bit_writer_destroy(out);
+            break;
+        }
+
+        ssize_t written = pwrite(w->fd_out, out->buffer, out->buffer_len, w->index->input_offsets[i]);
+        assert(written == (ssize_t) out->buffer_len);
+        bit_writer_destroy(out);
+    }
+
+    if (d != NULL){
+        dictionary_destroy(d);
+    }
+    else{
+        array_destroy(a);
+    }
+    if (hr != NULL){
+        huffman_reader_destroy(hr);
+    }
+    bit_reader_destroy(br);
+    close_file(fp_in);
+    return NULL;
+}
+
+
+bool decompress_parallel(const char* file_in, FILE* fp_out, 
+                            const SegmentIndex index, long input_size, int threads, const Header h){
+    assert(file_in != NULL && fp_out != NULL && index != NULL);
+    assert(threads >= 1);
+
+    struct _Worker w;
+    w.file_in = file_in;
+    w.index = index;
+    w.input_size = input_size;
+    w.h = h;
+    w.fd_out = fileno(fp_out);
+    w.next = 0;
+    w.failed = false;
+    pthread_mutex_init(&w.lock, NULL);
+
+    // pre-size the output, so every thread can write at its own offset
+    fflush(fp_out);
+    int result = ftruncate(w.fd_out, input_size);
+    assert(result == 0);
+
+    pthread_t* tids = (pthread_t*) malloc(threads * sizeof(pthread_t));
+    assert(tids != NULL);
+
+    for (int i = 0; i < threads; i++){
+        pthread_create(&tids[i], NULL, decompress_segments, &w);
+    }
 
-        // free curr_key
-        free(curr_key);
-        curr_key = NULL;
+    for (int i = 0; i < threads; i++){
+        pthread_join(tids[i], NULL);
     }
 
-    // return true if decompression finish
-    // return false if meet reflush
-    return flag;
+    pthread_mutex_destroy(&w.lock);
+    free(tids);
+    return ! w.failed;
 }
 
 
@@ -7,6 +7,7 @@
 #include "util.h"
 #include "data_structure.h"
 #include "file.h"
+#include "huffman.h"
 
 
 // check if the input file has .LZW at the end
@@ -16,10 +17,42 @@ bool check_input_file(const char*);
 // delete .LZW, and add deLZW at front
 char* create_decompressed_file_name(const char*);
 
+// how a decompression cycle ends
+#define CYCLE_REFLUSH 0     // meet reflush, the next cycle starts a new table
+#define CYCLE_EOF 1         // meet eof, the decompression is finished
+#define CYCLE_ERROR -1      // not a valid .LZW file: past the end of file,
+                            //      or a codeword that is not in the table,
+                            //      or the output would be over the limit of out
+
+// read one codeword of "bits" bits from the bit reader,
+// or from the huffman blocks if hr is not NULL
+// return -1 if the codeword goes beyond the end of file, or is not valid
+CodeWord read_from_file(BitReader br, HuffmanReader hr, const int bits);
+
 // decompression cycle, each cycle ends when reach index = reflush
-bool decompression_cycle(
-    int* buffer, int* buffer_bits_not_read,
-    Array a, FILE* fp_in, FILE* fp_out
+// the strings are copied into the buffer of the byte output "out"
+// return CYCLE_REFLUSH, CYCLE_EOF or CYCLE_ERROR
+int decompression_cycle(BitReader br, HuffmanReader hr, Array a, BitWriter out);
+
+// the same for GROWTH_LZMW and GROWTH_LZAP, the decoder grows the 
+// dictionary in the same way as the encoder
+int decompression_cycle_grow(BitReader br, HuffmanReader hr, Dictionary d, BitWriter out);
+
+// decode the whole file from the bit reader, the header is already read
+// return false if it is not a valid .LZW file, the output is then incomplete
+bool decompress_serial(BitReader br, const Header h, BitWriter out);
+
+// read the segment index at the end of the file, and the original size
+// return NULL if the file has no index
+SegmentIndex read_index_from_file(FILE* fp, long* input_size);
+
+// decode the segments of the index with "threads" threads,
+// the output file is first extended to the original size, and 
+// each segment is written with pwrite at its own input offset
+// return false if a segment is not valid
+bool decompress_parallel(
+    const char* file_in, FILE* fp_out, 
+    const SegmentIndex index, long input_size, int threads, const Header h
 );
 
 // print input and output file names
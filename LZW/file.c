@@ -1,12 +1,25 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
+#include <sys/stat.h>
 #include "file.h"
 
 
+// bit writer, move whole bytes from the accumulator into the buffer
+void bit_writer_drain(BitWriter bw);
+
+// bit reader, top up the accumulator from the buffer
+void bit_reader_refill(BitReader br);
+
+
 // open the file, exit if error during opening
 FILE* open_file_for_read(const char* file_name){
+    if (strcmp(file_name, STREAM_NAME) == 0){
+        return stdin;
+    }
+
     FILE* fp = fopen(file_name, "rb");
     assert(fp != NULL);
     return fp;
@@ -15,12 +28,24 @@ FILE* open_file_for_read(const char* file_name){
 
 // open the file for writing
 FILE* open_file_for_write(const char* file_name){
+    if (strcmp(file_name, STREAM_NAME) == 0){
+        return stdout;
+    }
+
     FILE* fp = fopen(file_name, "wb");
     assert(fp != NULL);
     return fp;
 }
 
 
+bool file_is_regular(FILE* fp){
+    assert(fp != NULL);
+
+    struct stat st;
+    return fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+
 // close the file
 FILE* close_file(FILE* fp){
     fclose(fp);
@@ -39,4 +64,483 @@ long file_size(FILE* fp){
     fseek(fp, 0L, SEEK_SET);    // same as rewind(fp)
 
     return result;
+}
+
+
+unsigned char* io_buffer_create(long size){
+    assert(size > 0);
+
+    void* buffer = NULL;
+    int err = posix_memalign(&buffer, IO_ALIGN, size);
+    assert(err == 0 && buffer != NULL);
+
+    return (unsigned char*) buffer;
+}
+
+
+// move whole bytes from the accumulator into the buffer
+// at most 7 bits remain in the accumulator
+void bit_writer_drain(BitWriter bw){
+    while (bw->acc_bits >= 8){
+        bw->acc_bits -= 8;
+
+        // in memory, the bytes past the limit are dropped
+        if (bw->buffer_len == bw->limit){
+            bw->overflow = true;
+            continue;
+        }
+
+        bw->buffer[bw->buffer_len] = (unsigned char) (bw->acc >> bw->acc_bits);
+        bw->buffer_len += 1;
+
+        if (bw->buffer_len == bw->buffer_size){
+            if (bw->fp != NULL){
+                fwrite(bw->buffer, 1, bw->buffer_len, bw->fp);
+                bw->written += bw->buffer_len;
+                bw->buffer_len = 0;
+            }
+            else{
+                // in memory, double the size every time
+                bw->buffer_size *= 2;
+                bw->buffer = (unsigned char*) realloc(bw->buffer, bw->buffer_size);
+                assert(bw->buffer != NULL);
+            }
+        }
+    }
+
+    return;
+}
+
+
+BitWriter bit_writer_create(FILE* fp){
+    BitWriter bw = (BitWriter) malloc(sizeof(struct _BitWriter));
+    assert(bw != NULL);
+
+    bw->buffer = io_buffer_create(IO_BUFFER_SIZE);
+
+    bw->fp = fp;
+    bw->acc = 0;
+    bw->acc_bits = 0;
+    bw->buffer_len = 0;
+    bw->buffer_size = IO_BUFFER_SIZE;
+    bw->written = 0;
+    bw->limit = -1;
+    bw->overflow = false;
+
+    return bw;
+}
+
+
+// flush everything before free, the pending bits (< 8) are dropped,
+// call bit_writer_pad first to keep them
+BitWriter bit_writer_destroy(BitWriter bw){
+    assert(bw != NULL);
+
+    bit_writer_flush(bw);
+
+    free(bw->buffer);
+    bw->buffer = NULL;
+    free(bw);
+    bw = NULL;
+    return bw;
+}
+
+
+// one shift and one mask for the whole code
+// the accumulator is only drained when the next code does not fit
+void bit_writer_put(BitWriter bw, uint64_t code, int bits){
+    assert(bw != NULL);
+    assert(bits >= 0 && bits <= 32);
+
+    if (bw->acc_bits + bits > 64){
+        bit_writer_drain(bw);
+    }
+
+    bw->acc = (bw->acc << bits) | (code & ((UINT64_C(1) << bits) - 1));
+    bw->acc_bits += bits;
+
+    return;
+}
+
+
+// pad the remaining bits with 0, if no remaining bits, do nothing
+void bit_writer_pad(BitWriter bw){
+    assert(bw != NULL);
+
+    int remain = bw->acc_bits % 8;
+    if (remain != 0){
+        bit_writer_put(bw, 0, 8 - remain);
+    }
+
+    return;
+}
+
+
+// the buffer is never left full, the next drain writes into it
+void bit_writer_put_bytes(BitWriter bw, const unsigned char* bytes, long len){
+    assert(bw != NULL && bytes != NULL);
+    assert(bit_writer_is_aligned(bw));
+
+    if (bw->acc_bits > 0){
+        bit_writer_drain(bw);
+    }
+
+    // in memory, keep what fits within the limit
+    if (! bit_writer_has_room(bw, len)){
+        bw->overflow = true;
+        len = bw->limit - bw->buffer_len;
+    }
+
+    if (bw->buffer_len + len < bw->buffer_size){
+        memcpy(bw->buffer + bw->buffer_len, bytes, len);
+        bw->buffer_len += len;
+        return;
+    }
+
+    if (bw->fp != NULL){
+        bit_writer_flush(bw);
+        fwrite(bytes, 1, len, bw->fp);
+        bw->written += len;
+    }
+    else{
+        while (bw->buffer_len + len >= bw->buffer_size){
+            bw->buffer_size *= 2;
+            bw->buffer = (unsigned char*) realloc(bw->buffer, bw->buffer_size);
+            assert(bw->buffer != NULL);
+        }
+
+        memcpy(bw->buffer + bw->buffer_len, bytes, len);
+        bw->buffer_len += len;
+    }
+
+    return;
+}
+
+
+void bit_writer_flush(BitWriter bw){
+    assert(bw != NULL);
+
+    bit_writer_drain(bw);
+
+    if (bw->fp != NULL && bw->buffer_len > 0){
+        fwrite(bw->buffer, 1, bw->buffer_len, bw->fp);
+        bw->written += bw->buffer_len;
+        bw->buffer_len = 0;
+    }
+
+    return;
+}
+
+
+bool bit_writer_is_aligned(const BitWriter bw){
+    assert(bw != NULL);
+    return bw->acc_bits % 8 == 0;
+}
+
+
+long bit_writer_tell(const BitWriter bw){
+    assert(bw != NULL);
+    return (bw->written + bw->buffer_len) * 8 + bw->acc_bits;
+}
+
+
+void bit_writer_clear(BitWriter bw){
+    assert(bw != NULL && bw->fp == NULL);
+
+    bw->acc = 0;
+    bw->acc_bits = 0;
+    bw->buffer_len = 0;
+    bw->limit = -1;
+    bw->overflow = false;
+    return;
+}
+
+
+void bit_writer_set_limit(BitWriter bw, long limit){
+    assert(bw != NULL && bw->fp == NULL);
+    assert(limit >= -1);
+
+    bw->limit = limit;
+    return;
+}
+
+
+bool bit_writer_has_room(const BitWriter bw, long len){
+    assert(bw != NULL);
+    return bw->limit < 0 || (! bw->overflow && bw->buffer_len + len <= bw->limit);
+}
+
+
+BitReader bit_reader_create(FILE* fp){
+    BitReader br = (BitReader) malloc(sizeof(struct _BitReader));
+    assert(br != NULL);
+
+    // in memory, the buffer is the caller's bytes
+    br->buffer = NULL;
+    if (fp != NULL){
+        br->buffer = io_buffer_create(IO_BUFFER_SIZE);
+    }
+
+    br->fp = fp;
+    br->acc = 0;
+    br->acc_bits = 0;
+    br->buffer_len = 0;
+    br->buffer_pos = 0;
+    br->zero_bits = 0;
+
+    return br;
+}
+
+
+BitReader bit_reader_destroy(BitReader br){
+    assert(br != NULL);
+
+    if (br->fp != NULL){
+        free(br->buffer);
+    }
+    br->buffer = NULL;
+    free(br);
+    br = NULL;
+    return br;
+}
+
+
+// top up the accumulator to at least 57 bits
+// one fread for every IO_BUFFER_SIZE bytes
+void bit_reader_refill(BitReader br){
+    while (br->acc_bits <= 56){
+        if (br->buffer_pos == br->buffer_len){
+            if (br->fp != NULL){
+                br->buffer_len = fread(br->buffer, 1, IO_BUFFER_SIZE, br->fp);
+                br->buffer_pos = 0;
+            }
+
+            if (br->buffer_pos == br->buffer_len){
+                // end of file, shift in 0 bits
+                br->acc <<= 8;
+                br->acc_bits += 8;
+                br->zero_bits += 8;
+                continue;
+            }
+        }
+
+        br->acc = (br->acc << 8) | br->buffer[br->buffer_pos];
+        br->buffer_pos += 1;
+        br->acc_bits += 8;
+    }
+
+    return;
+}
+
+
+uint64_t bit_reader_peek(BitReader br, int bits){
+    assert(br != NULL);
+    assert(bits >= 0 && bits <= 32);
+
+    if (br->acc_bits < bits){
+        bit_reader_refill(br);
+    }
+
+    return (br->acc >> (br->acc_bits - bits)) & ((UINT64_C(1) << bits) - 1);
+}
+
+
+uint64_t bit_reader_get(BitReader br, int bits){
+    assert(br != NULL);
+    assert(bits >= 0 && bits <= 32);
+
+    if (br->acc_bits < bits){
+        bit_reader_refill(br);
+    }
+
+    br->acc_bits -= bits;
+    return (br->acc >> br->acc_bits) & ((UINT64_C(1) << bits) - 1);
+}
+
+
+// the 0 bits are below the real ones, so some of them are gone
+// as soon as fewer bits are left than were shifted in
+bool bit_reader_is_past_end(const BitReader br){
+    assert(br != NULL);
+    return br->acc_bits < br->zero_bits;
+}
+
+
+void bit_reader_seek(BitReader br, long bit_offset){
+    assert(br != NULL && br->fp != NULL);
+    assert(bit_offset >= 0);
+
+    fseek(br->fp, bit_offset / 8, SEEK_SET);
+
+    br->acc = 0;
+    br->acc_bits = 0;
+    br->buffer_len = 0;
+    br->buffer_pos = 0;
+    br->zero_bits = 0;
+
+    // skip the bits before the offset in the first byte
+    bit_reader_get(br, bit_offset % 8);
+    return;
+}
+
+
+// the accumulator is refilled by whole bytes, so the bits 
+// of a partly read byte are the lowest acc_bits % 8
+void bit_reader_align(BitReader br){
+    assert(br != NULL);
+    br->acc_bits -= br->acc_bits % 8;
+    return;
+}
+
+
+void bit_reader_set_bytes(BitReader br, const unsigned char* bytes, long len){
+    assert(br != NULL && br->fp == NULL);
+    assert(bytes != NULL || len == 0);
+
+    br->buffer = (unsigned char*) bytes;
+    br->buffer_len = len;
+    br->buffer_pos = 0;
+    br->acc = 0;
+    br->acc_bits = 0;
+    br->zero_bits = 0;
+    return;
+}
+
+
+Header header_create(void){
+    Header h = (Header) malloc(sizeof(struct _Header));
+    assert(h != NULL);
+
+    h->policy = 0;
+    h->coder = 0;
+    h->growth = 0;
+    h->dict_id = 0;
+    h->seed = NULL;
+    return h;
+}
+
+
+Header header_destroy(Header h){
+    assert(h != NULL);
+    free(h);
+    h = NULL;
+    return h;
+}
+
+
+bool header_is_needed(const Header h){
+    assert(h != NULL);
+    return h->policy != 0 || h->coder != 0 || h->growth != 0 || h->dict_id != 0;
+}
+
+
+void header_print(BitWriter bw, const Header h){
+    assert(bw != NULL && h != NULL);
+
+    if (! header_is_needed(h)){
+        return;
+    }
+
+    for (int i = 0; i < 3; i++){
+        bit_writer_put(bw, HEADER_MAGIC[i], 8);
+    }
+
+    bit_writer_put(bw, HEADER_FIELDS, 8);
+    bit_writer_put(bw, h->policy, 8);
+    bit_writer_put(bw, h->coder, 8);
+    bit_writer_put(bw, h->growth, 8);
+    bit_writer_put(bw, h->dict_id, 8);
+    return;
+}
+
+
+// fields unknown to this version are skipped
+bool header_read(BitReader br, Header h){
+    assert(br != NULL && h != NULL);
+
+    if (bit_reader_peek(br, 8) != (uint64_t) HEADER_MAGIC[0]){
+        return true;
+    }
+
+    for (int i = 0; i < 3; i++){
+        uint64_t magic = bit_reader_get(br, 8);
+        if (magic != (uint64_t) HEADER_MAGIC[i]){
+            return false;
+        }
+    }
+
+    int fields = bit_reader_get(br, 8);
+    for (int i = 0; i < fields; i++){
+        int value = bit_reader_get(br, 8);
+        if (i == 0){
+            h->policy = value;
+        }
+        else if (i == 1){
+            h->coder = value;
+        }
+        else if (i == 2){
+            h->growth = value;
+        }
+        else if (i == 3){
+            h->dict_id = value;
+        }
+    }
+
+    return ! bit_reader_is_past_end(br);
+}
+
+
+void seed_print(const char* file_name, const Seed s){
+    assert(file_name != NULL && s != NULL);
+
+    FILE* fp = open_file_for_write(file_name);
+    BitWriter bw = bit_writer_create(fp);
+
+    for (int i = 0; i < 4; i++){
+        bit_writer_put(bw, SEED_MAGIC[i], 8);
+    }
+
+    bit_writer_put(bw, s->id, 8);
+    bit_writer_put(bw, BITS, 8);
+    bit_writer_put(bw, s->count, 16);
+
+    for (long i = 0; i < s->count; i++){
+        bit_writer_put(bw, s->prefix[i], 16);
+        bit_writer_put(bw, s->suffix[i], 8);
+    }
+
+    bit_writer_destroy(bw);
+    close_file(fp);
+    return;
+}
+
+
+Seed seed_read(const char* file_name){
+    assert(file_name != NULL);
+
+    FILE* fp = open_file_for_read(file_name);
+    BitReader br = bit_reader_create(fp);
+
+    for (int i = 0; i < 4; i++){
+        uint64_t magic = bit_reader_get(br, 8);
+        assert(magic == (uint64_t) SEED_MAGIC[i]);
+    }
+
+    int id = bit_reader_get(br, 8);
+    int bits = bit_reader_get(br, 8);
+    long count = bit_reader_get(br, 16);
+    assert(bits == BITS);
+
+    Seed s = seed_create(id, count);
+
+    // the prefix must be a char or an earlier entry
+    for (long i = 0; i < count; i++){
+        s->prefix[i] = bit_reader_get(br, 16);
+        s->suffix[i] = bit_reader_get(br, 8);
+        assert(s->prefix[i] < 256 || (s->prefix[i] >= INDEX_FIRST && s->prefix[i] < INDEX_FIRST + i));
+    }
+
+    bit_reader_destroy(br);
+    close_file(fp);
+    return s;
 }
\ No newline at end of file
@@ -4,17 +4,173 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "data_structure.h"
 
-// open file for read, mode = rb
+
+// size of the byte buffer behind the bit writer and bit reader, and of 
+// the input blocks of compress. the buffers start at a page boundary
+#define IO_BUFFER_SIZE (1 << 17)
+#define IO_ALIGN 4096
+
+
+// bit writer: codes are packed msb first into a 64 bits accumulator,
+// whole bytes are moved into the buffer, and the buffer is written in one fwrite
+// without a file (fp = NULL), the buffer grows and keeps all bytes in memory
+struct _BitWriter{
+    FILE* fp;
+    uint64_t acc;               // pending bits, the valid ones are the lowest acc_bits
+    int acc_bits;
+    unsigned char* buffer;
+    long buffer_len;
+    long buffer_size;
+    long written;               // bytes already written to the file
+    long limit;                 // in memory only, most bytes it may hold, -1 for none
+    bool overflow;              // bytes past the limit were dropped
+};
+typedef struct _BitWriter* BitWriter;
+
+
+// bit reader: the reverse, refill the accumulator from a large fread buffer
+// without a file (fp = NULL), it reads the bytes given by bit_reader_set_bytes
+struct _BitReader{
+    FILE* fp;
+    uint64_t acc;
+    int acc_bits;
+    unsigned char* buffer;
+    long buffer_len;
+    long buffer_pos;
+    long zero_bits;             // 0 bits shifted in after the end, they are 
+                                //      always the lowest bits of acc
+};
+typedef struct _BitReader* BitReader;
+
+
+// optional file header: "LZW", number of fields, then one byte per field
+// a file without header always starts with a byte <= 4 (the top bits of a
+// codeword < 258), so it can not be taken as "L".
+// the plain format (all fields 0) is printed without header, as before
+#define HEADER_MAGIC "LZW"
+#define HEADER_FIELDS 4
+
+struct _Header{
+    int policy;         // field 0, what to do when the dictionary is full
+    int coder;          // field 1, how the codewords are printed
+    int growth;         // field 2, how the dictionary grows
+    int dict_id;        // field 3, id of the seed dictionary, 0 for none
+    Seed seed;          // not printed, the seed of dict_id, owned by the caller
+};
+typedef struct _Header* Header;
+
+
+// the file name for stdin / stdout
+#define STREAM_NAME "-"
+
+// open file for read, mode = rb, "-" for stdin
 FILE* open_file_for_read(const char* file_name);
 
-// open file for write, mode = wb         
+// open file for write, mode = wb, "-" for stdout
 FILE* open_file_for_write(const char* file_name);   
 
+// true for a regular file, which can seek, false for a pipe or terminal
+bool file_is_regular(FILE* fp);
+
 // close file
 FILE* close_file(FILE* fp);
 
 // get the file size, return long
 long file_size(FILE* fp);
 
+// a buffer of "size" bytes aligned to IO_ALIGN, free it with free
+unsigned char* io_buffer_create(long size);
+
+
+// bit writer, create / destroy, destroy also flush the buffer
+// fp = NULL for an in-memory writer, the bytes are then in buffer[0, buffer_len)
+BitWriter bit_writer_create(FILE* fp);
+BitWriter bit_writer_destroy(BitWriter);
+
+// append the lowest "bits" bits of the code, max 32 bits a time
+void bit_writer_put(BitWriter, uint64_t code, int bits);
+
+// pad the pending bits with 0 to a whole byte
+void bit_writer_pad(BitWriter);
+
+// append whole bytes, the bits written so far must be whole bytes too
+// short spans are copied into the buffer, long ones are written straight away
+void bit_writer_put_bytes(BitWriter, const unsigned char* bytes, long len);
+
+// write all whole bytes to the file
+void bit_writer_flush(BitWriter);
+
+// true if the bits written so far make whole bytes
+bool bit_writer_is_aligned(const BitWriter);
+
+// total number of bits written so far
+long bit_writer_tell(const BitWriter);
+
+// in memory only, drop everything and start again, the buffer is kept
+// and the limit is removed
+void bit_writer_clear(BitWriter);
+
+// in memory only, at most "limit" bytes are kept, -1 for no limit
+// the bytes past the limit are dropped, and the writer has no room any more
+void bit_writer_set_limit(BitWriter, long limit);
+
+// true if len more bytes are within the limit, and none was dropped
+bool bit_writer_has_room(const BitWriter, long len);
+
+
+// bit reader, create / destroy
+// fp = NULL for an in-memory reader
+BitReader bit_reader_create(FILE* fp);
+BitReader bit_reader_destroy(BitReader);
+
+// read the next "bits" bits, max 32 bits a time
+// reading beyond the end of file gives 0 bits
+uint64_t bit_reader_get(BitReader, int bits);
+
+// true once a bit beyond the end of file has been read
+bool bit_reader_is_past_end(const BitReader);
+
+// look at the next "bits" bits without reading them, max 32 bits
+uint64_t bit_reader_peek(BitReader, int bits);
+
+// move to the given bit offset of the file, drop everything buffered
+void bit_reader_seek(BitReader, long bit_offset);
+
+// skip the rest of a partly read byte
+void bit_reader_align(BitReader);
+
+// in memory only, read these bytes from the start, they are not copied 
+// and must stay until the reading is done
+void bit_reader_set_bytes(BitReader, const unsigned char* bytes, long len);
+
+
+// header create and destroy, all fields are 0 (the plain format)
+Header header_create(void);
+Header header_destroy(Header);
+
+// true if any field is not 0, so the header must be printed
+bool header_is_needed(const Header);
+
+// print the header, if needed
+void header_print(BitWriter, const Header);
+
+// read the header if the file has one, otherwise leave all fields 0
+// the bit reader must be at the start of the file
+// return false if the header is cut short or damaged
+bool header_read(BitReader, Header);
+
+
+// seed dictionary file: "LZWD", id (8 bits), BITS (8 bits), 
+// number of entries (16 bits), then prefix (16 bits) + char (8 bits) each
+#define SEED_MAGIC "LZWD"
+
+// write the seed to a new file
+void seed_print(const char* file_name, const Seed);
+
+// read a seed file, it must be made for the same BITS
+Seed seed_read(const char* file_name);
+
 #endif
\ No newline at end of file
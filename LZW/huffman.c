@@ -0,0 +1,422 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "data_structure.h"
+#include "file.h"
+#include "huffman.h"
+
+
+// build the code lengths from the frequencies, Static_Huffman style
+// the tree only keeps the parent of each node, leaves are the symbols
+void huffman_build_lengths(const long* freq, int* lengths);
+
+// give canonical codes in order of (length, symbol)
+void huffman_build_words(const int* lengths, uint32_t* words);
+
+// read the block header and build the decode tables, false if not valid
+bool huffman_reader_read_block(HuffmanReader hr);
+
+
+// single chars, eof and reflush are symbols of their own
+// then v = cw - 258: small v are symbols too,
+// otherwise the leading 1 of v gives the range, the next
+// HUFFMAN_SUB_BITS bits are part of the symbol, and the rest are extra
+int huffman_symbol(const CodeWord cw, int* extra_bits, uint32_t* extra){
+    assert(cw >= 0 && cw < SIZE_LIMIT);
+    assert(extra_bits != NULL && extra != NULL);
+
+    *extra_bits = 0;
+    *extra = 0;
+
+    if (cw < INDEX_FIRST){
+        return cw;
+    }
+
+    uint32_t v = cw - INDEX_FIRST;
+    if (v < (1 << HUFFMAN_SUB_BITS)){
+        return INDEX_FIRST + v;
+    }
+
+    // position of the leading 1
+    int k = 31 - __builtin_clz(v);
+
+    *extra_bits = k - HUFFMAN_SUB_BITS;
+    *extra = v & ((1 << *extra_bits) - 1);
+
+    int top = (v >> *extra_bits) & ((1 << HUFFMAN_SUB_BITS) - 1);
+    return INDEX_FIRST + (1 << HUFFMAN_SUB_BITS) * (1 + k - HUFFMAN_SUB_BITS) + top;
+}
+
+
+// the reverse of huffman_symbol
+CodeWord huffman_codeword(const int symbol, BitReader br){
+    assert(symbol >= 0 && symbol < HUFFMAN_SYMBOLS);
+
+    if (symbol < INDEX_FIRST){
+        return symbol;
+    }
+
+    int s = symbol - INDEX_FIRST;
+    if (s < (1 << HUFFMAN_SUB_BITS)){
+        return INDEX_FIRST + s;
+    }
+
+    int k = s / (1 << HUFFMAN_SUB_BITS) - 1 + HUFFMAN_SUB_BITS;
+    int top = s % (1 << HUFFMAN_SUB_BITS);
+    int extra_bits = k - HUFFMAN_SUB_BITS;
+
+    uint32_t v = ((uint32_t) ((1 << HUFFMAN_SUB_BITS) | top) << extra_bits)
+                    | (uint32_t) bit_reader_get(br, extra_bits);
+    return INDEX_FIRST + v;
+}
+
+
+// like the priority queue of Static_Huffman, the queue is kept in
+// decreasing order of weight by insertion, the smallest is at the end
+void huffman_build_lengths(const long* freq, int* lengths){
+    int nodes = 2 * HUFFMAN_SYMBOLS;
+    long* weight = (long*) malloc(nodes * sizeof(long));
+    int* parent = (int*) malloc(nodes * sizeof(int));
+    int* queue = (int*) malloc(nodes * sizeof(int));
+    assert(weight != NULL && parent != NULL && queue != NULL);
+
+    int count = 0;
+    int next = HUFFMAN_SYMBOLS;
+
+    for (int i = 0; i < HUFFMAN_SYMBOLS; i++){
+        lengths[i] = 0;
+        if (freq[i] == 0){
+            continue;
+        }
+
+        weight[i] = freq[i];
+        parent[i] = -1;
+
+        // insert, keep decreasing order
+        int idx = count;
+        while (idx > 0 && weight[queue[idx-1]] < weight[i]){
+            queue[idx] = queue[idx-1];
+            idx -= 1;
+        }
+        queue[idx] = i;
+        count += 1;
+    }
+
+    // a single symbol still needs 1 bit
+    if (count == 1){
+        lengths[queue[0]] = 1;
+    }
+
+    // merge the 2 smallest into a new internal node
+    while (count > 1){
+        int a = queue[count-1];
+        int b = queue[count-2];
+        count -= 2;
+
+        weight[next] = weight[a] + weight[b];
+        parent[next] = -1;
+        parent[a] = next;
+        parent[b] = next;
+
+        int idx = count;
+        while (idx > 0 && weight[queue[idx-1]] < weight[next]){
+            queue[idx] = queue[idx-1];
+            idx -= 1;
+        }
+        queue[idx] = next;
+        count += 1;
+        next += 1;
+    }
+
+    // the code length is the depth of the leaf
+    for (int i = 0; i < HUFFMAN_SYMBOLS && next > HUFFMAN_SYMBOLS; i++){
+        if (freq[i] == 0){
+            continue;
+        }
+
+        int depth = 0;
+        for (int n = i; parent[n] != -1; n = parent[n]){
+            depth += 1;
+        }
+        assert(depth <= HUFFMAN_MAX_LENGTH);
+        lengths[i] = depth;
+    }
+
+    free(weight);
+    free(parent);
+    free(queue);
+    return;
+}
+
+
+// the first code of each length follows the last code of the length before
+void huffman_build_words(const int* lengths, uint32_t* words){
+    int count[HUFFMAN_MAX_LENGTH + 1] = {0};
+    uint32_t next[HUFFMAN_MAX_LENGTH + 1];
+
+    for (int i = 0; i < HUFFMAN_SYMBOLS; i++){
+        count[lengths[i]] += 1;
+    }
+    count[0] = 0;
+
+    uint32_t code = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_LENGTH; len++){
+        code = (code + count[len-1]) << 1;
+        next[len] = code;
+    }
+
+    for (int i = 0; i < HUFFMAN_SYMBOLS; i++){
+        if (lengths[i] != 0){
+            words[i] = next[lengths[i]];
+            next[lengths[i]] += 1;
+        }
+    }
+
+    return;
+}
+
+
+HuffmanBlock huffman_block_create(void){
+    HuffmanBlock hb = (HuffmanBlock) malloc(sizeof(struct _HuffmanBlock));
+    assert(hb != NULL);
+
+    hb->codes = (Code*) malloc(HUFFMAN_BLOCK * sizeof(Code));
+    hb->symbols = (Code*) malloc(HUFFMAN_BLOCK * sizeof(Code));
+    hb->freq = (long*) calloc(HUFFMAN_SYMBOLS, sizeof(long));
+    hb->lengths = (int*) malloc(HUFFMAN_SYMBOLS * sizeof(int));
+    hb->words = (uint32_t*) malloc(HUFFMAN_SYMBOLS * sizeof(uint32_t));
+    hb->extra_bits = (int*) malloc(HUFFMAN_SYMBOLS * sizeof(int));
+    assert(hb->codes != NULL && hb->symbols != NULL && hb->freq != NULL);
+    assert(hb->lengths != NULL && hb->words != NULL && hb->extra_bits != NULL);
+
+    // the number of extra bits only depends on the symbol
+    uint32_t extra;
+    for (CodeWord cw = 0; cw < SIZE_LIMIT; cw++){
+        int extra_bits;
+        hb->extra_bits[huffman_symbol(cw, &extra_bits, &extra)] = extra_bits;
+    }
+
+    hb->count = 0;
+    return hb;
+}
+
+
+HuffmanBlock huffman_block_destroy(HuffmanBlock hb){
+    assert(hb != NULL);
+
+    free(hb->codes);
+    free(hb->symbols);
+    free(hb->freq);
+    free(hb->lengths);
+    free(hb->words);
+    free(hb->extra_bits);
+    free(hb);
+    hb = NULL;
+    return hb;
+}
+
+
+void huffman_block_put(HuffmanBlock hb, const CodeWord cw){
+    assert(hb != NULL && ! huffman_block_is_full(hb));
+
+    int extra_bits;
+    uint32_t extra;
+    int symbol = huffman_symbol(cw, &extra_bits, &extra);
+
+    hb->codes[hb->count] = cw;
+    hb->symbols[hb->count] = symbol;
+    hb->count += 1;
+    hb->freq[symbol] += 1;
+    return;
+}
+
+
+bool huffman_block_is_full(const HuffmanBlock hb){
+    assert(hb != NULL);
+    return hb->count == HUFFMAN_BLOCK;
+}
+
+
+void huffman_block_print(HuffmanBlock hb, BitWriter bw){
+    assert(hb != NULL && bw != NULL);
+
+    if (hb->count == 0){
+        return;
+    }
+
+    huffman_build_lengths(hb->freq, hb->lengths);
+    huffman_build_words(hb->lengths, hb->words);
+
+    // block header
+    bit_writer_put(bw, hb->count, 16);
+    for (int i = 0; i < HUFFMAN_SYMBOLS; i++){
+        if (hb->lengths[i] == 0){
+            bit_writer_put(bw, 0, 1);
+        }
+        else{
+            bit_writer_put(bw, 1, 1);
+            bit_writer_put(bw, hb->lengths[i], HUFFMAN_LENGTH_BITS);
+        }
+    }
+
+    // the codewords, the extra bits are the lowest bits of codeword - 258
+    int symbol;
+    int extra_bits;
+
+    for (long i = 0; i < hb->count; i++){
+        symbol = hb->symbols[i];
+        extra_bits = hb->extra_bits[symbol];
+        bit_writer_put(bw, hb->words[symbol], hb->lengths[symbol]);
+        bit_writer_put(bw, (hb->codes[i] - INDEX_FIRST) & ((1 << extra_bits) - 1), extra_bits);
+    }
+
+    bit_writer_pad(bw);
+
+    // start a new block
+    memset(hb->freq, 0, HUFFMAN_SYMBOLS * sizeof(long));
+    hb->count = 0;
+    return;
+}
+
+
+HuffmanReader huffman_reader_create(BitReader br){
+    assert(br != NULL);
+
+    HuffmanReader hr = (HuffmanReader) malloc(sizeof(struct _HuffmanReader));
+    assert(hr != NULL);
+
+    hr->br = br;
+    hr->remaining = 0;
+    hr->lengths = (int*) malloc(HUFFMAN_SYMBOLS * sizeof(int));
+    hr->sorted = (int*) malloc(HUFFMAN_SYMBOLS * sizeof(int));
+    hr->table = (int*) malloc((1 << HUFFMAN_TABLE_BITS) * sizeof(int));
+    assert(hr->lengths != NULL && hr->sorted != NULL && hr->table != NULL);
+
+    return hr;
+}
+
+
+HuffmanReader huffman_reader_destroy(HuffmanReader hr){
+    assert(hr != NULL);
+
+    free(hr->lengths);
+    free(hr->sorted);
+    free(hr->table);
+    free(hr);
+    hr = NULL;
+    return hr;
+}
+
+
+void huffman_reader_reset(HuffmanReader hr){
+    assert(hr != NULL);
+    hr->remaining = 0;
+    return;
+}
+
+
+// a block starts at a byte, skip the padding of the block before
+// return false if the block is not valid, then nothing can be read
+bool huffman_reader_read_block(HuffmanReader hr){
+    BitReader br = hr->br;
+
+    bit_reader_align(br);
+    hr->remaining = bit_reader_get(br, 16);
+    if (hr->remaining == 0){
+        return false;
+    }
+
+    for (int len = 0; len <= HUFFMAN_MAX_LENGTH; len++){
+        hr->count[len] = 0;
+    }
+
+    for (int i = 0; i < HUFFMAN_SYMBOLS; i++){
+        hr->lengths[i] = 0;
+        if (bit_reader_get(br, 1) == 1){
+            hr->lengths[i] = bit_reader_get(br, HUFFMAN_LENGTH_BITS);
+        }
+        hr->count[hr->lengths[i]] += 1;
+    }
+    hr->count[0] = 0;
+
+    // first code and position in sorted of each length
+    uint32_t code = 0;
+    int position = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_LENGTH; len++){
+        code = (code + hr->count[len-1]) << 1;
+        hr->first[len] = code;
+        hr->offset[len] = position;
+        position += hr->count[len];
+
+        // more codes than the length allows, the table would overflow
+        if (code + hr->count[len] > (UINT64_C(1) << len)){
+            hr->remaining = 0;
+            return false;
+        }
+    }
+
+    int next[HUFFMAN_MAX_LENGTH + 1];
+    memcpy(next, hr->offset, sizeof(next));
+    for (int i = 0; i < HUFFMAN_SYMBOLS; i++){
+        if (hr->lengths[i] != 0){
+            hr->sorted[next[hr->lengths[i]]] = i;
+            next[hr->lengths[i]] += 1;
+        }
+    }
+
+    // every short code fills all table entries starting with it
+    for (int i = 0; i < (1 << HUFFMAN_TABLE_BITS); i++){
+        hr->table[i] = -1;
+    }
+
+    for (int len = 1; len <= HUFFMAN_TABLE_BITS; len++){
+        for (int j = 0; j < hr->count[len]; j++){
+            int symbol = hr->sorted[hr->offset[len] + j];
+            int shift = HUFFMAN_TABLE_BITS - len;
+            uint32_t start = (hr->first[len] + j) << shift;
+
+            for (uint32_t t = 0; t < (1u << shift); t++){
+                hr->table[start + t] = (symbol << 5) | len;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+// short codes by the table, longer ones one length at a time
+CodeWord huffman_reader_get(HuffmanReader hr){
+    assert(hr != NULL);
+
+    if (hr->remaining == 0 && ! huffman_reader_read_block(hr)){
+        return -1;
+    }
+    hr->remaining -= 1;
+
+    BitReader br = hr->br;
+    int symbol = -1;
+    int entry = hr->table[bit_reader_peek(br, HUFFMAN_TABLE_BITS)];
+
+    if (entry != -1){
+        bit_reader_get(br, entry & 31);
+        symbol = entry >> 5;
+    }
+    else{
+        for (int len = HUFFMAN_TABLE_BITS + 1; len <= HUFFMAN_MAX_LENGTH; len++){
+            uint32_t code = bit_reader_peek(br, len);
+            if (code - hr->first[len] < (uint32_t) hr->count[len]){
+                bit_reader_get(br, len);
+                symbol = hr->sorted[hr->offset[len] + code - hr->first[len]];
+                break;
+            }
+        }
+    }
+
+    // no code of the block starts with these bits
+    if (symbol == -1){
+        return -1;
+    }
+    return huffman_codeword(symbol, br);
+}
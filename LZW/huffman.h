@@ -0,0 +1,113 @@
+#ifndef _HUFFMAN_H_
+#define _HUFFMAN_H_
+
+/*
+LZW-H: the codewords printed by LZW are Huffman coded, block by block,
+instead of being printed with BITS bits each.
+
+The codewords are not used evenly: single chars and the entries added
+just before are much more common, and at the start of a dictionary only
+the lower codewords exist. But most entries are only printed a few times,
+so one Huffman symbol per codeword needs a table larger than the gain.
+So like the distances of deflate, a codeword >= 258 is split into a
+symbol for its range (the top bits), and the remaining bits are printed
+as they are. The single chars, eof and reflush are symbols of their own.
+
+Each block is byte aligned:
+    number of codewords (16 bits)
+    for each symbol: 1 bit used or not, then the code length (5 bits) if used
+    the codewords
+    0 padding to a whole byte
+A block ends after HUFFMAN_BLOCK codewords, and always after reflush or eof,
+so a new segment starts at a byte with a new block.
+
+The tree is built the same way as Static_Huffman: frequency table,
+priority queue of tree nodes, merge the 2 smallest until one is left.
+Only the depth of each leaf is kept, and the codes are canonical,
+so that the lengths are enough for the decoder.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "data_structure.h"
+#include "file.h"
+
+
+// the coder field of the header
+#define CODER_FIXED 0
+#define CODER_HUFFMAN 1
+
+
+// a codeword >= 258 is split into a symbol with the top HUFFMAN_SUB_BITS
+// bits after the leading 1, and the lower bits printed as they are
+#define HUFFMAN_SUB_BITS 2
+#define HUFFMAN_SYMBOLS (INDEX_FIRST + (1 << HUFFMAN_SUB_BITS) * (1 + BITS - HUFFMAN_SUB_BITS))
+
+#define HUFFMAN_BLOCK 16384             // max number of codewords in a block
+#define HUFFMAN_LENGTH_BITS 5           // bits to print a code length
+#define HUFFMAN_MAX_LENGTH 31           // a block of 16384 is at most 20 deep
+#define HUFFMAN_TABLE_BITS 10           // codes up to this length are decoded
+                                        //      by a single table look up
+
+
+// compression: the codewords of the block are kept until it is full
+struct _HuffmanBlock{
+    Code* codes;
+    Code* symbols;              // symbol of each codeword
+    long count;
+    long* freq;                 // number of each symbol in the block
+    int* lengths;               // code length of each symbol
+    uint32_t* words;            // canonical code of each symbol
+    int* extra_bits;            // number of extra bits after each symbol
+};
+typedef struct _HuffmanBlock* HuffmanBlock;
+
+
+// decompression: the table of the current block
+struct _HuffmanReader{
+    BitReader br;
+    long remaining;             // codewords left in this block, 0 = read a new block
+    int* lengths;
+    int* sorted;                // symbols in canonical order
+    uint32_t first[HUFFMAN_MAX_LENGTH + 1];     // first code of each length
+    int count[HUFFMAN_MAX_LENGTH + 1];          // number of codes of each length
+    int offset[HUFFMAN_MAX_LENGTH + 1];         // position in sorted of the first
+    int* table;                 // symbol << 5 | length, -1 for a longer code
+};
+typedef struct _HuffmanReader* HuffmanReader;
+
+
+// symbol of a codeword, and the bits printed after it
+int huffman_symbol(const CodeWord cw, int* extra_bits, uint32_t* extra);
+// codeword of a symbol, the bits after it are read from br
+CodeWord huffman_codeword(const int symbol, BitReader br);
+
+
+// block create / destroy
+HuffmanBlock huffman_block_create(void);
+HuffmanBlock huffman_block_destroy(HuffmanBlock);
+
+// add a codeword to the block
+void huffman_block_put(HuffmanBlock, const CodeWord cw);
+// true if no more codeword can be added
+bool huffman_block_is_full(const HuffmanBlock);
+// build the code, print the block and start a new empty one
+void huffman_block_print(HuffmanBlock, BitWriter);
+
+
+// reader create / destroy, the bit reader is owned by the caller
+HuffmanReader huffman_reader_create(BitReader br);
+HuffmanReader huffman_reader_destroy(HuffmanReader);
+
+// forget the current block, the next read starts a new one
+// used after the bit reader moves to a new segment
+void huffman_reader_reset(HuffmanReader);
+
+// read the next codeword, the block header is read when needed
+// return -1 if the block is not valid
+CodeWord huffman_reader_get(HuffmanReader);
+
+#endif
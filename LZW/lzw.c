@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "lzw.h"
+#include "decompress_func.h"
+
+
+// input bytes encoded between two checks of the output size
+#define LZW_STEP 4096
+
+
+LzwContext lzw_ctx_create(const int max_bits){
+    assert(max_bits >= MIN_BITS && max_bits <= BITS);
+
+    LzwContext ctx = (LzwContext) malloc(sizeof(struct _LzwContext));
+    assert(ctx != NULL);
+
+    ctx->bits = max_bits;
+    ctx->h = header_create();
+    ctx->out = bit_writer_create(NULL);
+    ctx->in = bit_reader_create(NULL);
+
+    ctx->e = encoder_create(ctx->out, NULL, ctx->h);
+    dictionary_set_bits(ctx->e->d, max_bits);
+
+    ctx->a = array_create(ctx->h->policy);
+    array_set_bits(ctx->a, max_bits);
+
+    return ctx;
+}
+
+
+LzwContext lzw_ctx_destroy(LzwContext ctx){
+    assert(ctx != NULL);
+
+    encoder_destroy(ctx->e);
+    array_destroy(ctx->a);
+    bit_writer_destroy(ctx->out);
+    bit_reader_destroy(ctx->in);
+    header_destroy(ctx->h);
+    free(ctx);
+    ctx = NULL;
+    return ctx;
+}
+
+
+void lzw_ctx_set_seed(LzwContext ctx, const Seed seed){
+    assert(ctx != NULL);
+
+    dictionary_set_seed(ctx->e->d, seed);
+    array_set_seed(ctx->a, seed);
+    return;
+}
+
+
+// at most one codeword per byte, a reflush each time the dictionary 
+// is full, and the last codeword + eof
+long lzw_compress_bound(const LzwContext ctx, const long n){
+    assert(ctx != NULL && n >= 0);
+
+    long entries = ((long) 1 << ctx->bits) - INDEX_FIRST;
+    long codes = n + n / entries + 2;
+    return (codes * ctx->bits + 7) / 8;
+}
+
+
+long lzw_compress(LzwContext ctx, const unsigned char* src, const long n, 
+                    unsigned char* dst, const long cap){
+    assert(ctx != NULL && (src != NULL || n == 0));
+    assert(dst != NULL || cap == 0);
+
+    // the writer keeps at most cap bytes, the encoder stops soon after
+    bit_writer_clear(ctx->out);
+    bit_writer_set_limit(ctx->out, cap);
+    encoder_reset(ctx->e);
+
+    for (long pos = 0; pos < n && bit_writer_has_room(ctx->out, 0); pos += LZW_STEP){
+        long step = (n - pos < LZW_STEP) ? n - pos : LZW_STEP;
+        encoder_put_bytes(ctx->e, src + pos, step);
+    }
+
+    encoder_finish(ctx->e, INDEX_EOF);
+    bit_writer_pad(ctx->out);
+    bit_writer_flush(ctx->out);
+
+    if (! bit_writer_has_room(ctx->out, 0)){
+        return -1;
+    }
+
+    long len = ctx->out->buffer_len;
+    memcpy(dst, ctx->out->buffer, len);
+    return len;
+}
+
+
+long lzw_decompress(LzwContext ctx, const unsigned char* src, const long n, 
+                    unsigned char* dst, const long cap){
+    assert(ctx != NULL && (src != NULL || n == 0));
+    assert(dst != NULL || cap == 0);
+
+    // the decoder stops as soon as the output would be more than cap
+    bit_writer_clear(ctx->out);
+    bit_writer_set_limit(ctx->out, cap);
+    bit_reader_set_bytes(ctx->in, src, n);
+
+    // the same loop as decompress_serial, the array is only reset
+    ctx->a = array_reset(ctx->a);
+    int status = decompression_cycle(ctx->in, NULL, ctx->a, ctx->out);
+    while (status == CYCLE_REFLUSH){
+        ctx->a = array_reset(ctx->a);
+        status = decompression_cycle(ctx->in, NULL, ctx->a, ctx->out);
+    }
+
+    // cut short, damaged, or too large for dst
+    if (status == CYCLE_ERROR){
+        return -1;
+    }
+
+    long len = ctx->out->buffer_len;
+    memcpy(dst, ctx->out->buffer, len);
+    return len;
+}
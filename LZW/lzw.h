@@ -0,0 +1,58 @@
+#ifndef _LZW_H_
+#define _LZW_H_
+
+/*
+In-memory LZW for many small payloads, without the files and main().
+
+A context owns one dictionary, one array and the byte buffers, 
+allocated once. Each call resets them in O(1) (see dictionary_reset), 
+so a thread can compress message after message without allocating. 
+A context is used by one thread at a time, use one context per thread.
+
+The output is the plain LZW stream: codewords of max_bits bits, reflush 
+whenever the dictionary is full, eof at the end, padded to a whole byte. 
+There is no header, so the decoder must use the same max_bits.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "data_structure.h"
+#include "file.h"
+#include "compress_func.h"
+
+
+struct _LzwContext{
+    int bits;               // codeword length, MIN_BITS to BITS
+    Header h;               // the plain format, all fields 0
+    Encoder e;
+    Array a;
+    BitWriter out;          // in memory, the result before it is copied
+    BitReader in;           // in memory, reads the source of lzw_decompress
+};
+typedef struct _LzwContext* LzwContext;
+
+
+// create with codewords of max_bits bits, MIN_BITS to BITS
+// the tables are sized for BITS, so max_bits only moves the reflush point
+LzwContext lzw_ctx_create(const int max_bits);
+LzwContext lzw_ctx_destroy(LzwContext);
+
+// start every message from a seed dictionary (see train), 
+// before the first message. the seed is owned by the caller
+void lzw_ctx_set_seed(LzwContext, const Seed);
+
+// largest output of lzw_compress for n input bytes
+long lzw_compress_bound(const LzwContext, const long n);
+
+// compress n bytes of src into dst, return the output size,
+// or -1 if it is more than cap, then it stops soon after cap bytes
+long lzw_compress(LzwContext, const unsigned char* src, const long n, 
+                    unsigned char* dst, const long cap);
+
+// decompress n bytes of src (a whole output of lzw_compress) into dst, 
+// return the output size, or -1 if it is more than cap, or if src
+// is cut short or is not an output of lzw_compress
+long lzw_decompress(LzwContext, const unsigned char* src, const long n, 
+                    unsigned char* dst, const long cap);
+
+#endif
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "lzw.h"
+
+
+// lzw_compress with just enough and too little room, then feed
+// lzw_decompress whole, empty, truncated and damaged payloads.
+// a bad payload must give -1, never loop or write past cap
+
+
+#define SAMPLE_SIZE 20000
+
+
+// text with repeats, long enough for a few reflushes at 9 bits
+void make_sample(unsigned char* buffer, long n){
+    const char* words[] = {"the ", "dictionary ", "is ", "full ", "reflush ", "\n", "LZW "};
+    long pos = 0;
+    unsigned int r = 1;
+
+    while (pos < n){
+        r = r * 1103515245 + 12345;
+        const char* w = words[(r >> 16) % 7];
+        long len = strlen(w);
+        if (pos + len > n){
+            len = n - pos;
+        }
+        memcpy(buffer + pos, w, len);
+        pos += len;
+    }
+    return;
+}
+
+
+void test_bits(const int bits, const unsigned char* sample, long n){
+    LzwContext ctx = lzw_ctx_create(bits);
+
+    long bound = lzw_compress_bound(ctx, n);
+    unsigned char* packed = (unsigned char*) malloc(bound);
+    unsigned char* output = (unsigned char*) malloc(n + 1);
+    assert(packed != NULL && output != NULL);
+
+    long packed_len = lzw_compress(ctx, sample, n, packed, bound);
+    assert(packed_len > 0);
+
+    // just enough room, and one byte less
+    assert(lzw_compress(ctx, sample, n, packed, packed_len) == packed_len);
+    assert(lzw_compress(ctx, sample, n, packed, packed_len - 1) == -1);
+
+    // the whole payload, with just enough room, and with one byte less
+    assert(lzw_decompress(ctx, packed, packed_len, output, n + 1) == n);
+    assert(memcmp(output, sample, n) == 0);
+    assert(lzw_decompress(ctx, packed, packed_len, output, n) == n);
+    assert(lzw_decompress(ctx, packed, packed_len, output, n - 1) == -1);
+
+    // empty, and every prefix: the eof codeword is in the last byte
+    long rejected = 0;
+    for (long len = 0; len < packed_len; len++){
+        if (lzw_decompress(ctx, packed, len, output, n + 1) == -1){
+            rejected += 1;
+        }
+    }
+    assert(rejected == packed_len);
+
+    // one damaged byte, the result is anything within cap, or -1
+    unsigned char* damaged = (unsigned char*) malloc(packed_len);
+    assert(damaged != NULL);
+
+    for (long i = 0; i < packed_len; i += 1 + packed_len / 500){
+        memcpy(damaged, packed, packed_len);
+        damaged[i] ^= 0x5A;
+        long len = lzw_decompress(ctx, damaged, packed_len, output, n + 1);
+        assert(len == -1 || (len >= 0 && len <= n + 1));
+    }
+
+    // the context still works after all the errors
+    assert(lzw_decompress(ctx, packed, packed_len, output, n + 1) == n);
+    assert(memcmp(output, sample, n) == 0);
+
+    fprintf(stdout, "bits = %d: %ld bytes -> %ld bytes, %ld prefixes rejected\n",
+            bits, n, packed_len, rejected);
+
+    free(damaged);
+    free(output);
+    free(packed);
+    lzw_ctx_destroy(ctx);
+    return;
+}
+
+
+int main(void){
+    unsigned char* sample = (unsigned char*) malloc(SAMPLE_SIZE);
+    assert(sample != NULL);
+    make_sample(sample, SAMPLE_SIZE);
+
+    test_bits(MIN_BITS, sample, SAMPLE_SIZE);
+    test_bits(12, sample, SAMPLE_SIZE);
+    test_bits(BITS, sample, SAMPLE_SIZE);
+
+    // a single byte
+    test_bits(BITS, sample, 1);
+
+    free(sample);
+    fprintf(stdout, "all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include "file.h"
+#include "data_structure.h"
+#include "train_func.h"
+
+
+/*
+Build a seed dictionary from sample files, for many small files 
+of the same kind (json records, logs). 
+compress -D and decompress -D then start every dictionary from it.
+*/
+
+int main(int argc, char** argv){
+
+    // output seed file, number of entries, and the id kept in the header
+    char* file_out = NULL;
+    long entries = TRAIN_ENTRIES;
+    int id = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:n:d:")) != -1){
+        if (opt == 'o'){
+            file_out = optarg;
+        }
+        else if (opt == 'n'){
+            entries = atol(optarg);
+        }
+        else if (opt == 'd'){
+            id = atoi(optarg);
+        }
+        else{
+            file_out = NULL;
+            break;
+        }
+    }
+
+    if (file_out == NULL || optind >= argc || entries < 0 || entries > SEED_MAX || id < 1 || id > 255){
+        fprintf(stderr, "Usage: %s -o <seed> [-n entries, max %d] [-d id, 1 - 255] <sample> ...\n", 
+                argv[0], SEED_MAX);
+        exit(EXIT_FAILURE);
+    }
+
+    Trainer t = trainer_create();
+    for (int i = optind; i < argc; i++){
+        trainer_add_file(t, argv[i]);
+    }
+
+    Seed s = trainer_select(t, entries, id);
+    seed_print(file_out, s);
+
+    fprintf(stdout, "LZW seed dictionary:\n");
+    fprintf(stdout, "%d samples, %ld Bytes => %ld entries, id %d, in \"%s\"\n", 
+            argc - optind, t->input_size, s->count, s->id, file_out);
+
+    seed_destroy(s);
+    trainer_destroy(t);
+    return 0;
+}
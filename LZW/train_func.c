@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "train_func.h"
+
+
+// qsort order of the candidates, most hits first, then smallest codeword
+int compare_hits(const void* x, const void* y);
+
+// the hits of the candidates, only used during qsort
+long* sort_hits = NULL;
+
+
+Trainer trainer_create(void){
+    Trainer t = (Trainer) malloc(sizeof(struct _Trainer));
+    assert(t != NULL);
+
+    t->d = dictionary_create(RESET_FULL, GROWTH_LZW);
+    t->uses = (long*) calloc(SIZE_LIMIT, sizeof(long));
+    assert(t->uses != NULL);
+    t->input_size = 0;
+
+    return t;
+}
+
+
+Trainer trainer_destroy(Trainer t){
+    assert(t != NULL);
+
+    dictionary_destroy(t->d);
+    free(t->uses);
+    free(t);
+    t = NULL;
+    return t;
+}
+
+
+// the same loop as the encoder, once full the dictionary only 
+// stops growing, it is never reset
+void trainer_add_file(Trainer t, const char* file_name){
+    assert(t != NULL && file_name != NULL);
+
+    FILE* fp = open_file_for_read(file_name);
+    unsigned char* input = io_buffer_create(IO_BUFFER_SIZE);
+    size_t input_len;
+    CodeWord prev = -1;
+    CodeWord cw;
+    int c;
+
+    while ((input_len = fread(input, 1, IO_BUFFER_SIZE, fp)) > 0){
+        t->input_size += input_len;
+
+        for (size_t i = 0; i < input_len; i++){
+            c = input[i];
+            cw = dictionary_search(t->d, prev, c);
+            if (cw != -1){
+                prev = cw;
+                continue;
+            }
+
+            t->uses[prev] += 1;
+            dictionary_insert(t->d, prev, c);
+            prev = c;
+        }
+    }
+
+    if (prev != -1){
+        t->uses[prev] += 1;
+    }
+
+    free(input);
+    close_file(fp);
+    return;
+}
+
+
+int compare_hits(const void* x, const void* y){
+    Index a = *(const Index*) x;
+    Index b = *(const Index*) y;
+
+    if (sort_hits[a] != sort_hits[b]){
+        return sort_hits[a] < sort_hits[b] ? 1 : -1;
+    }
+    return a < b ? -1 : 1;
+}
+
+
+Seed trainer_select(Trainer t, const long entries, const int id){
+    assert(t != NULL && entries >= 0 && entries <= SEED_MAX);
+
+    Dictionary d = t->d;
+    long* hits = (long*) malloc(SIZE_LIMIT * sizeof(long));
+    Index* order = (Index*) malloc(SIZE_LIMIT * sizeof(Index));
+    Index* renumber = (Index*) malloc(SIZE_LIMIT * sizeof(Index));
+    assert(hits != NULL && order != NULL && renumber != NULL);
+
+    // children always come after their prefix, so one backward pass
+    // adds up the hits of the whole subtree
+    for (Index cw = 0; cw < d->current_num; cw++){
+        hits[cw] = t->uses[cw];
+    }
+    for (Index cw = d->current_num - 1; cw >= INDEX_FIRST; cw--){
+        hits[d->prefix[cw]] += hits[cw];
+    }
+
+    long candidates = 0;
+    for (Index cw = INDEX_FIRST; cw < d->current_num; cw++){
+        if (hits[cw] >= TRAIN_MIN_HITS){
+            order[candidates] = cw;
+            candidates += 1;
+        }
+    }
+
+    sort_hits = hits;
+    qsort(order, candidates, sizeof(Index), compare_hits);
+    sort_hits = NULL;
+
+    long count = candidates < entries ? candidates : entries;
+
+    // mark the kept ones, then number them in the old order
+    for (Index cw = 0; cw < SIZE_LIMIT; cw++){
+        renumber[cw] = -1;
+    }
+    for (long i = 0; i < count; i++){
+        renumber[order[i]] = 0;
+    }
+
+    Seed s = seed_create(id, count);
+    long n = 0;
+
+    for (Index cw = INDEX_FIRST; cw < d->current_num; cw++){
+        if (renumber[cw] == -1){
+            continue;
+        }
+
+        Index prefix = d->prefix[cw];
+        if (prefix >= INDEX_FIRST){
+            assert(renumber[prefix] != -1);
+            prefix = renumber[prefix];
+        }
+
+        renumber[cw] = INDEX_FIRST + n;
+        s->prefix[n] = prefix;
+        s->suffix[n] = d->suffix[cw];
+        n += 1;
+    }
+
+    assert(n == count);
+    free(hits);
+    free(order);
+    free(renumber);
+    return s;
+}
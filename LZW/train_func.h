@@ -0,0 +1,47 @@
+#ifndef _TRAIN_FUNC_H_
+#define _TRAIN_FUNC_H_
+
+/*
+Build a seed dictionary from sample files.
+
+All samples are parsed by plain LZW with one dictionary, which keeps 
+growing from one sample to the next until it is full, and every 
+codeword printed is counted. An entry is walked through each time it 
+or a longer entry on top of it is printed, so its "hits" are its own 
+count plus the hits of its children. The seed keeps the entries with 
+the most hits. A prefix has at least the hits of its children and a 
+smaller codeword, so the kept entries always include their prefixes.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "file.h"
+#include "data_structure.h"
+
+
+// default number of seed entries, and the entries need at least
+// TRAIN_MIN_HITS hits to be worth keeping
+#define TRAIN_ENTRIES 4096
+#define TRAIN_MIN_HITS 2
+
+
+// the training state
+struct _Trainer{
+    Dictionary d;
+    long* uses;         // number of times each codeword is printed
+    long input_size;    // chars of all samples
+};
+typedef struct _Trainer* Trainer;
+
+
+// create / destroy
+Trainer trainer_create(void);
+Trainer trainer_destroy(Trainer);
+
+// parse one sample file, each sample starts a new match
+void trainer_add_file(Trainer, const char* file_name);
+
+// keep the "entries" best entries, numbered in codeword order
+Seed trainer_select(Trainer, const long entries, const int id);
+
+#endif